@@ -0,0 +1,779 @@
+                section         .text
+
+                global          _start
+
+                %define         SZ 128
+                %define         INPUT_SIZE 4096
+
+                ; stack frame layout, offsets in bytes
+                %define         NUM_A           0
+                %define         NUM_B           SZ * 8
+                %define         MODULUS         2 * SZ * 8
+                %define         R_SQUARED       (3 * SZ + 1) * 8
+                %define         SCRATCH         (4 * SZ + 2) * 8
+                %define         FRAME_SIZE      (6 * SZ + 4) * 8
+_start:
+
+                sub             rsp, FRAME_SIZE
+                mov             rdi, rsp
+                mov             rcx, FRAME_SIZE / 8
+                call            set_zero
+
+                lea             rdi, [rsp + NUM_A]
+                mov             rcx, SZ
+                call            read_long
+                lea             rdi, [rsp + NUM_B]
+                call            read_long
+                lea             rdi, [rsp + MODULUS]
+                call            read_long
+
+                test            qword [rsp + MODULUS], 1
+                jz              .even_modulus
+
+                ; r12 -- length of Montgomery numbers, R = 2^(64 * r12) > a, b, n
+                lea             rdi, [rsp + NUM_A]
+                call            len_long
+                mov             r12, rax
+                lea             rdi, [rsp + NUM_B]
+                call            len_long
+                cmp             rax, r12
+                cmova           r12, rax
+                lea             rdi, [rsp + MODULUS]
+                call            len_long
+                cmp             rax, r12
+                cmova           r12, rax
+
+                mov             rbx, [rsp + MODULUS]
+                call            neg_inverse_short
+                mov             r13, rax
+
+                lea             rdi, [rsp + R_SQUARED]
+                lea             r8, [rsp + MODULUS]
+                mov             rcx, r12
+                call            r_squared_mod
+
+                ; a := a * R mod n, i.e. a in Montgomery form
+                lea             rdi, [rsp + NUM_A]
+                lea             rsi, [rsp + R_SQUARED]
+                mov             r9, r13
+                lea             r10, [rsp + SCRATCH]
+                call            mont_mul_long_long
+
+                ; a := (a * R) * b / R mod n, b is kept in normal form so the
+                ; product leaves Montgomery form in the same multiplication
+                lea             rsi, [rsp + NUM_B]
+                call            mont_mul_long_long
+
+                mov             rcx, SZ
+                call            write_long
+
+                mov             al, 0x0a
+                call            write_char
+
+                jmp             exit
+
+.even_modulus:
+                mov             rsi, even_modulus_msg
+                mov             rdx, even_modulus_msg_size
+                call            print_string
+                jmp             exit
+
+; adds two long number
+;    rdi -- address of summand #1 (long number)
+;    rsi -- address of summand #2 (long number)
+;    rcx -- length of long numbers in qwords
+; result:
+;    sum is written to rdi
+add_long_long:
+                push            rdi
+                push            rsi
+                push            rcx
+
+                clc
+.loop:
+                mov             rax, [rsi]
+                lea             rsi, [rsi + 8]
+                adc             [rdi], rax
+                lea             rdi, [rdi + 8]
+                dec             rcx
+                jnz             .loop
+
+                pop             rcx
+                pop             rsi
+                pop             rdi
+                ret
+
+; adds 64-bit number to long number
+;    rdi -- address of summand #1 (long number)
+;    rax -- summand #2 (64-bit unsigned)
+;    rcx -- length of long number in qwords
+; result:
+;    sum is written to rdi
+add_long_short:
+                push            rdi
+                push            rcx
+                push            rdx
+
+                xor             rdx,rdx
+.loop:
+                add             [rdi], rax
+                adc             rdx, 0
+                mov             rax, rdx
+                xor             rdx, rdx
+                add             rdi, 8
+                dec             rcx
+                jnz             .loop
+
+                pop             rdx
+                pop             rcx
+                pop             rdi
+                ret
+
+; multiplies long number by a short
+;    rdi -- address of multiplier #1 (long number)
+;    rbx -- multiplier #2 (64-bit unsigned)
+;    rcx -- length of long number in qwords
+; result:
+;    product is written to rdi
+mul_long_short:
+                push            rax
+                push            rdi
+                push            rcx
+                push            rsi
+
+                xor             rsi, rsi
+.loop:
+                mov             rax, [rdi]
+                mul             rbx
+                add             rax, rsi
+                adc             rdx, 0
+                mov             [rdi], rax
+                add             rdi, 8
+                mov             rsi, rdx
+                dec             rcx
+                jnz             .loop
+
+                pop             rsi
+                pop             rcx
+                pop             rdi
+                pop             rax
+                ret
+
+; divides long number by a short
+;    rdi -- address of dividend (long number)
+;    rbx -- divisor (64-bit unsigned)
+;    rcx -- length of long number in qwords
+; result:
+;    quotient is written to rdi
+;    rdx -- remainder
+div_long_short:
+                push            rdi
+                push            rax
+                push            rcx
+
+                lea             rdi, [rdi + 8 * rcx - 8]
+                xor             rdx, rdx
+
+.loop:
+                mov             rax, [rdi]
+                div             rbx
+                mov             [rdi], rax
+                sub             rdi, 8
+                dec             rcx
+                jnz             .loop
+
+                pop             rcx
+                pop             rax
+                pop             rdi
+                ret
+
+; assigns a zero to long number
+;    rdi -- argument (long number)
+;    rcx -- length of long number in qwords
+set_zero:
+                push            rax
+                push            rdi
+                push            rcx
+
+                xor             rax, rax
+                rep stosq
+
+                pop             rcx
+                pop             rdi
+                pop             rax
+                ret
+
+; checks if a long number is a zero
+;    rdi -- argument (long number)
+;    rcx -- length of long number in qwords
+; result:
+;    ZF=1 if zero
+is_zero:
+                push            rax
+                push            rdi
+                push            rcx
+
+                xor             rax, rax
+                rep scasq
+
+                pop             rcx
+                pop             rdi
+                pop             rax
+                ret
+
+; read long number from stdin, full blocks of 16 characters are validated
+; and converted to a 64-bit value at once with SSE4.1, everything else
+; goes through read_char one character at a time
+;    rdi -- location for output (long number)
+;    rcx -- length of long number in qwords
+read_long:
+                push            rcx
+                push            rdi
+
+                call            set_zero
+                movdqa          xmm4, [digits_zero]
+                movdqa          xmm5, [digits_nine]
+                movdqa          xmm6, [digits_newline]
+.block:
+                mov             rax, [input_len]
+                sub             rax, [input_pos]
+                cmp             rax, 16
+                jae             .load
+                ; a short tail may already hold the newline, so stdin is read
+                ; again only once the tail is used up by the scalar loop
+                or              rax, rax
+                jnz             .loop
+                call            fill_input
+                cmp             rax, 16
+                jb              .loop
+.load:
+                mov             rax, [input_pos]
+                movdqu          xmm0, [input_buf + rax]
+                movdqa          xmm1, xmm0
+                pcmpeqb         xmm1, xmm6
+                pmovmskb        r11d, xmm1
+                psubb           xmm0, xmm4
+                movdqa          xmm1, xmm0
+                pminub          xmm1, xmm5
+                pcmpeqb         xmm1, xmm0
+                pmovmskb        edx, xmm1
+                cmp             edx, 0xffff
+                jne             .partial
+
+                ; 16 digits: pairs, then quads, then two 8-digit halves
+                pmaddubsw       xmm0, [digits_mul_10]
+                pmaddwd         xmm0, [digits_mul_100]
+                packusdw        xmm0, xmm0
+                pmaddwd         xmm0, [digits_mul_10000]
+                movq            rax, xmm0
+                mov             rdx, rax
+                shr             rdx, 32
+                mov             eax, eax
+                imul            rax, rax, 100000000
+                add             rax, rdx
+
+                mov             rbx, 10000000000000000
+                call            mul_long_short
+                call            add_long_short
+                add             qword [input_pos], 16
+                jmp             .block
+
+; r8 -- number of digits before the first other character
+.partial:
+                not             edx
+                bsf             r8d, edx
+                or              r8, r8
+                jz              .terminator
+
+                mov             rsi, [input_pos]
+                lea             rsi, [input_buf + rsi]
+                lea             r9, [rsi + r8]
+                xor             rax, rax
+                mov             rbx, 1
+.partial_loop:
+                imul            rax, rax, 10
+                imul            rbx, rbx, 10
+                movzx           rdx, byte [rsi]
+                sub             rdx, '0'
+                add             rax, rdx
+                inc             rsi
+                cmp             rsi, r9
+                jne             .partial_loop
+
+                call            mul_long_short
+                call            add_long_short
+                add             [input_pos], r8
+
+.terminator:
+                bt              r11d, r8d
+                jnc             .loop
+                inc             qword [input_pos]
+                jmp             .done
+
+.loop:
+                call            read_char
+                or              rax, rax
+                js              exit
+                cmp             rax, 0x0a
+                je              .done
+                cmp             rax, '0'
+                jb              .invalid_char
+                cmp             rax, '9'
+                ja              .invalid_char
+
+                sub             rax, '0'
+                mov             rbx, 10
+                call            mul_long_short
+                call            add_long_short
+                jmp             .block
+
+.done:
+                pop             rdi
+                pop             rcx
+                ret
+
+.invalid_char:
+                mov             rsi, invalid_char_msg
+                mov             rdx, invalid_char_msg_size
+                call            print_string
+                call            write_char
+                mov             al, 0x0a
+                call            write_char
+
+.skip_loop:
+                call            read_char
+                or              rax, rax
+                js              exit
+                cmp             rax, 0x0a
+                je              exit
+                jmp             .skip_loop
+
+; write long number to stdout
+;    rdi -- argument (long number)
+;    rcx -- length of long number in qwords
+write_long:
+                push            rax
+                push            rcx
+
+                mov             rax, 20
+                mul             rcx
+                mov             rbp, rsp
+                sub             rsp, rax
+
+                mov             rsi, rbp
+
+.loop:
+                mov             rbx, 10
+                call            div_long_short
+                add             rdx, '0'
+                dec             rsi
+                mov             [rsi], dl
+                call            is_zero
+                jnz             .loop
+
+                mov             rdx, rbp
+                sub             rdx, rsi
+                call            print_string
+
+                mov             rsp, rbp
+                pop             rcx
+                pop             rax
+                ret
+
+; read one char from stdin through input_buf
+; result:
+;    rax == -1 if error occurs
+;    rax \in [0; 255] if OK
+read_char:
+                push            rcx
+                push            rdi
+
+                mov             rcx, [input_pos]
+                cmp             rcx, [input_len]
+                jb              .ready
+                call            fill_input
+                or              rax, rax
+                jz              .error
+                mov             rcx, [input_pos]
+.ready:
+                movzx           rax, byte [input_buf + rcx]
+                inc             rcx
+                mov             [input_pos], rcx
+
+                pop             rdi
+                pop             rcx
+                ret
+.error:
+                mov             rax, -1
+                pop             rdi
+                pop             rcx
+                ret
+
+; moves unread input to the start of input_buf and reads more from stdin
+; result:
+;    rax -- number of unread bytes, 0 if input is over
+fill_input:
+                push            rcx
+                push            rdi
+                push            rsi
+                push            rdx
+
+                mov             rsi, [input_pos]
+                mov             rcx, [input_len]
+                sub             rcx, rsi
+                mov             [input_len], rcx
+                mov             qword [input_pos], 0
+                add             rsi, input_buf
+                mov             rdi, input_buf
+                rep movsb
+
+                xor             rax, rax
+                xor             rdi, rdi
+                mov             rsi, input_buf
+                add             rsi, [input_len]
+                mov             rdx, INPUT_SIZE
+                sub             rdx, [input_len]
+                syscall
+                cmp             rax, 0
+                jle             .done
+                add             [input_len], rax
+.done:
+                mov             rax, [input_len]
+
+                pop             rdx
+                pop             rsi
+                pop             rdi
+                pop             rcx
+                ret
+
+; write one char to stdout, errors are ignored
+;    al -- char
+write_char:
+                sub             rsp, 1
+                mov             [rsp], al
+
+                mov             rax, 1
+                mov             rdi, 1
+                mov             rsi, rsp
+                mov             rdx, 1
+                syscall
+                add             rsp, 1
+                ret
+
+exit:
+                mov             rax, 60
+                xor             rdi, rdi
+                syscall
+
+; print string to stdout
+;    rsi -- string
+;    rdx -- size
+print_string:
+                push            rax
+
+                mov             rax, 1
+                mov             rdi, 1
+                syscall
+
+                pop             rax
+                ret
+
+; copies long to long
+;   r11 -- address of num1 (long number)
+;   rdi -- address of num2 (long number)
+;   rcx -- length of numbers in qwords
+; result:
+;   [r11] := [rdi]
+copy_long_long:
+                push            r11
+                push            rdi
+                push            rcx
+                push            rax
+.loop:
+                mov             rax, [rdi]
+                lea             rdi, [rdi + 8]
+                mov             [r11], rax
+                lea             r11, [r11 + 8]
+                dec             rcx
+                jnz             .loop
+
+                pop             rax
+                pop             rcx
+                pop             rdi
+                pop             r11
+                ret
+
+; compares two long numbers
+;    rdi -- address of num1 (long number)
+;    rsi -- address of num2 (long number)
+;    rcx -- length of long numbers in qwords
+; result:
+;    flags are set as after unsigned "cmp [rdi], [rsi]"
+cmp_long_long:
+                push            rdi
+                push            rsi
+                push            rcx
+                push            rax
+
+                lea             rdi, [rdi + 8 * rcx - 8]
+                lea             rsi, [rsi + 8 * rcx - 8]
+.loop:
+                mov             rax, [rdi]
+                cmp             rax, [rsi]
+                jne             .done
+                lea             rdi, [rdi - 8]
+                lea             rsi, [rsi - 8]
+                dec             rcx
+                jnz             .loop
+                cmp             rax, rax
+.done:
+                pop             rax
+                pop             rcx
+                pop             rsi
+                pop             rdi
+                ret
+
+; subtracts long number from long number
+;    rdi -- address of minuend (long number)
+;    rsi -- address of subtrahend (long number)
+;    rcx -- length of long numbers in qwords
+; result:
+;    difference is written to rdi
+sub_long_long:
+                push            rdi
+                push            rsi
+                push            rcx
+                push            rax
+
+                clc
+.loop:
+                mov             rax, [rsi]
+                lea             rsi, [rsi + 8]
+                sbb             [rdi], rax
+                lea             rdi, [rdi + 8]
+                dec             rcx
+                jnz             .loop
+
+                pop             rax
+                pop             rcx
+                pop             rsi
+                pop             rdi
+                ret
+
+; finds the number of significant qwords in long number
+;    rdi -- argument (long number)
+;    rcx -- length of long number in qwords
+; result:
+;    rax -- index of the highest non-zero qword plus one, at least 1
+len_long:
+                push            rcx
+.loop:
+                cmp             qword [rdi + 8 * rcx - 8], 0
+                jne             .done
+                dec             rcx
+                jnz             .loop
+                inc             rcx
+.done:
+                mov             rax, rcx
+                pop             rcx
+                ret
+
+; adds product of long number and a short to long number
+;    rdi -- address of summand (long number, rcx + 2 qwords)
+;    rsi -- address of multiplier #1 (long number)
+;    rbx -- multiplier #2 (64-bit unsigned)
+;    rcx -- length of multiplier #1 in qwords
+; result:
+;    sum is written to rdi
+mul_add_long_short:
+                push            rax
+                push            rdx
+                push            rdi
+                push            rsi
+                push            rcx
+                push            r8
+
+                xor             r8, r8
+.loop:
+                mov             rax, [rsi]
+                mul             rbx
+                add             rax, r8
+                adc             rdx, 0
+                add             [rdi], rax
+                adc             rdx, 0
+                mov             r8, rdx
+                add             rsi, 8
+                add             rdi, 8
+                dec             rcx
+                jnz             .loop
+
+                add             [rdi], r8
+                adc             qword [rdi + 8], 0
+
+                pop             r8
+                pop             rcx
+                pop             rsi
+                pop             rdi
+                pop             rdx
+                pop             rax
+                ret
+
+; computes -n^(-1) mod 2^64 by Newton iteration, every step doubles
+; the number of correct low bits (n * n = 1 mod 8 gives the first three)
+;    rbx -- n (64-bit unsigned, odd)
+; result:
+;    rax -- -n^(-1) mod 2^64
+neg_inverse_short:
+                push            rcx
+                push            rdx
+
+                mov             rax, rbx
+                mov             rcx, 5
+.loop:
+                mov             rdx, rbx
+                imul            rdx, rax
+                neg             rdx
+                add             rdx, 2
+                imul            rax, rdx
+                dec             rcx
+                jnz             .loop
+                neg             rax
+
+                pop             rdx
+                pop             rcx
+                ret
+
+; computes R^2 mod n for R = 2^(64 * rcx) by doubling 1 modulo n
+;    rdi -- location for output (long number, rcx + 1 qwords)
+;    r8  -- address of modulus (long number, rcx + 1 qwords)
+;    rcx -- length of modulus in qwords
+r_squared_mod:
+                push            rcx
+                push            rsi
+                push            rdx
+
+                mov             rdx, rcx
+                shl             rdx, 7
+                inc             rcx
+                call            set_zero
+                mov             qword [rdi], 1
+
+                mov             rsi, r8
+                call            cmp_long_long
+                jb              .loop
+                call            sub_long_long
+.loop:
+                push            rsi
+                mov             rsi, rdi
+                call            add_long_long
+                pop             rsi
+                call            cmp_long_long
+                jb              .next
+                call            sub_long_long
+.next:
+                dec             rdx
+                jnz             .loop
+
+                pop             rdx
+                pop             rsi
+                pop             rcx
+                ret
+
+; multiplies two long numbers in Montgomery form, reduction is interleaved
+; with multiplication row by row (CIOS), the row window slides over scratch
+; instead of being shifted
+;    rdi -- address of num1 (long number, less than R)
+;    rsi -- address of num2 (long number, less than R)
+;    r8  -- address of modulus (long number, rcx + 1 qwords, odd)
+;    r9  -- -modulus^(-1) mod 2^64
+;    r10 -- address of scratch (2 * rcx + 2 qwords)
+;    rcx -- length of numbers in qwords, R = 2^(64 * rcx)
+; num1 * num2 must be less than modulus * R
+; result:
+;    num1 * num2 / R mod modulus is written to rdi
+mont_mul_long_long:
+                push            rbx
+                push            r11
+                push            r12
+                push            r13
+                push            r14
+                push            r15
+
+                mov             r13, rdi
+                push            rcx
+                mov             rdi, r10
+                lea             rcx, [rcx * 2 + 2]
+                call            set_zero
+                pop             rcx
+
+                mov             r12, r13
+                mov             r14, r10
+                mov             r15, rcx
+.loop:
+                mov             rbx, [r12]
+                mov             rdi, r14
+                call            mul_add_long_short
+
+                mov             rbx, [r14]
+                imul            rbx, r9
+                push            rsi
+                mov             rsi, r8
+                call            mul_add_long_short
+                pop             rsi
+
+                lea             r12, [r12 + 8]
+                lea             r14, [r14 + 8]
+                dec             r15
+                jnz             .loop
+
+                ; r14 -- result, less than 2 * modulus
+                mov             rdi, r14
+                push            rsi
+                mov             rsi, r8
+                inc             rcx
+                call            cmp_long_long
+                jb              .copy
+                call            sub_long_long
+.copy:
+                dec             rcx
+                pop             rsi
+                mov             r11, r13
+                call            copy_long_long
+                mov             rdi, r13
+
+                pop             r15
+                pop             r14
+                pop             r13
+                pop             r12
+                pop             r11
+                pop             rbx
+                ret
+
+                section         .rodata align=16
+invalid_char_msg:
+                db              "Invalid character: "
+invalid_char_msg_size: equ             $ - invalid_char_msg
+even_modulus_msg:
+                db              "Modulus must be odd", 0x0a
+even_modulus_msg_size: equ             $ - even_modulus_msg
+                align           16
+digits_zero:
+                times 16 db     '0'
+digits_nine:
+                times 16 db     9
+digits_newline:
+                times 16 db     0x0a
+digits_mul_10:
+                times 8 db      10, 1
+digits_mul_100:
+                times 4 dw      100, 1
+digits_mul_10000:
+                times 4 dw      10000, 1
+
+                section         .bss
+input_buf:
+                resb            INPUT_SIZE + 16
+input_pos:
+                resq            1
+input_len:
+                resq            1
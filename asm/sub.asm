@@ -2,20 +2,52 @@
 
                 global          _start
 
+                %ifdef          DECIMAL
+                ; decimal limbs: LIMB_DIGITS digits per qword, carry at LIMB_BASE,
+                ; 138 qwords hold every value of 128 binary qwords
+                %define         LIMB_DIGITS 18
+                %define         LIMB_BASE 1000000000000000000
+                %define         SZ 138
+                %else
                 %define         SZ 128
+                %endif
+                %define         INPUT_SIZE 4096
+
+                ; calls routine %1, with PROFILE defined its rdtsc cycle
+                ; count is added to the qword counter %2
+%macro          timed_call 2
+%ifdef PROFILE
+                lfence
+                rdtsc
+                shl             rdx, 32
+                or              rax, rdx
+                push            rax
+                call            %1
+                lfence
+                rdtsc
+                shl             rdx, 32
+                or              rax, rdx
+                sub             rax, [rsp]
+                add             [%2], rax
+                add             rsp, 8
+%else
+                call            %1
+%endif
+%endmacro
+
 _start:
 
 
                 sub             rsp, 3 * SZ * 8
                 lea             rdi, [rsp + SZ * 8]
                 mov             rcx, SZ
-                call            read_long
+                timed_call      read_long, cycles_read
                 mov             rdi, rsp
-                call            read_long
+                timed_call      read_long, cycles_read
                 lea             rsi, [rsp + SZ * 8]
                 lea             r10, [rsp + 2 * SZ * 8]
-                call            sub_long_long
-                call            write_long
+                timed_call      sub_long_long, cycles_compute
+                timed_call      write_long, cycles_write
 
                 mov             al, 0x0a
                 call            write_char
@@ -165,7 +197,10 @@ is_zero:
                 pop             rax
                 ret
 
-; read long number from stdin
+%ifndef DECIMAL
+; read long number from stdin, full blocks of 16 characters are validated
+; and converted to a 64-bit value at once with SSE4.1, everything else
+; goes through read_char one character at a time
 ;    rdi -- location for output (long number)
 ;    rcx -- length of long number in qwords
 read_long:
@@ -173,6 +208,85 @@ read_long:
                 push            rdi
 
                 call            set_zero
+                movdqa          xmm4, [digits_zero]
+                movdqa          xmm5, [digits_nine]
+                movdqa          xmm6, [digits_newline]
+.block:
+                mov             rax, [input_len]
+                sub             rax, [input_pos]
+                cmp             rax, 16
+                jae             .load
+                ; a short tail may already hold the newline, so stdin is read
+                ; again only once the tail is used up by the scalar loop
+                or              rax, rax
+                jnz             .loop
+                call            fill_input
+                cmp             rax, 16
+                jb              .loop
+.load:
+                mov             rax, [input_pos]
+                movdqu          xmm0, [input_buf + rax]
+                movdqa          xmm1, xmm0
+                pcmpeqb         xmm1, xmm6
+                pmovmskb        r11d, xmm1
+                psubb           xmm0, xmm4
+                movdqa          xmm1, xmm0
+                pminub          xmm1, xmm5
+                pcmpeqb         xmm1, xmm0
+                pmovmskb        edx, xmm1
+                cmp             edx, 0xffff
+                jne             .partial
+
+                ; 16 digits: pairs, then quads, then two 8-digit halves
+                pmaddubsw       xmm0, [digits_mul_10]
+                pmaddwd         xmm0, [digits_mul_100]
+                packusdw        xmm0, xmm0
+                pmaddwd         xmm0, [digits_mul_10000]
+                movq            rax, xmm0
+                mov             rdx, rax
+                shr             rdx, 32
+                mov             eax, eax
+                imul            rax, rax, 100000000
+                add             rax, rdx
+
+                mov             rbx, 10000000000000000
+                call            mul_long_short
+                call            add_long_short
+                add             qword [input_pos], 16
+                jmp             .block
+
+; r8 -- number of digits before the first other character
+.partial:
+                not             edx
+                bsf             r8d, edx
+                or              r8, r8
+                jz              .terminator
+
+                mov             rsi, [input_pos]
+                lea             rsi, [input_buf + rsi]
+                lea             r9, [rsi + r8]
+                xor             rax, rax
+                mov             rbx, 1
+.partial_loop:
+                imul            rax, rax, 10
+                imul            rbx, rbx, 10
+                movzx           rdx, byte [rsi]
+                sub             rdx, '0'
+                add             rax, rdx
+                inc             rsi
+                cmp             rsi, r9
+                jne             .partial_loop
+
+                call            mul_long_short
+                call            add_long_short
+                add             [input_pos], r8
+
+.terminator:
+                bt              r11d, r8d
+                jnc             .loop
+                inc             qword [input_pos]
+                jmp             .done
+
 .loop:
                 call            read_char
                 or              rax, rax
@@ -188,7 +302,7 @@ read_long:
                 mov             rbx, 10
                 call            mul_long_short
                 call            add_long_short
-                jmp             .loop
+                jmp             .block
 
 .done:
                 pop             rdi
@@ -243,7 +357,149 @@ write_long:
                 pop             rax
                 ret
 
-; read one char from stdin
+%else
+; read long number in decimal limbs from stdin, the whole line is collected
+; first and then cut into LIMB_DIGITS-character chunks from its end
+;    rdi -- location for output (long number)
+;    rcx -- length of long number in qwords
+read_long:
+                push            rcx
+                push            rdi
+                push            rbp
+
+                call            set_zero
+                imul            r10, rcx, LIMB_DIGITS
+                mov             rbp, rsp
+                sub             rsp, r10
+                mov             r8, rsp
+                xor             r9, r9
+.loop:
+                call            read_char
+                or              rax, rax
+                js              exit
+                cmp             rax, 0x0a
+                je              .limb
+                cmp             rax, '0'
+                jb              .invalid_char
+                cmp             rax, '9'
+                ja              .invalid_char
+                cmp             r9, r10
+                jae             .too_long
+
+                mov             [r8 + r9], al
+                inc             r9
+                jmp             .loop
+
+; r9 -- number of digits left, [r8 + r9 - LIMB_DIGITS; r8 + r9) is the next limb
+.limb:
+                or              r9, r9
+                jz              .done
+                xor             r11, r11
+                mov             rsi, r9
+                sub             rsi, LIMB_DIGITS
+                cmovb           rsi, r11
+                mov             r11, rsi
+
+                xor             rax, rax
+.digit:
+                imul            rax, 10
+                movzx           rdx, byte [r8 + rsi]
+                sub             rdx, '0'
+                add             rax, rdx
+                inc             rsi
+                cmp             rsi, r9
+                jb              .digit
+
+                mov             [rdi], rax
+                add             rdi, 8
+                mov             r9, r11
+                jmp             .limb
+
+.done:
+                mov             rsp, rbp
+                pop             rbp
+                pop             rdi
+                pop             rcx
+                ret
+
+.too_long:
+                mov             rsi, too_long_msg
+                mov             rdx, too_long_msg_size
+                call            print_string
+                jmp             exit
+
+.invalid_char:
+                mov             rsi, invalid_char_msg
+                mov             rdx, invalid_char_msg_size
+                call            print_string
+                call            write_char
+                mov             al, 0x0a
+                call            write_char
+
+.skip_loop:
+                call            read_char
+                or              rax, rax
+                js              exit
+                cmp             rax, 0x0a
+                je              exit
+                jmp             .skip_loop
+
+; write long number in decimal limbs to stdout, every limb except
+; the highest one is printed as exactly LIMB_DIGITS digits
+;    rdi -- argument (long number)
+;    rcx -- length of long number in qwords
+write_long:
+                push            rax
+                push            rcx
+
+                imul            rax, rcx, LIMB_DIGITS
+                mov             rbp, rsp
+                sub             rsp, rax
+
+                lea             r8, [rcx - 1]
+.find_top:
+                or              r8, r8
+                jz              .print
+                cmp             qword [rdi + 8 * r8], 0
+                jne             .print
+                dec             r8
+                jmp             .find_top
+
+.print:
+                mov             rsi, rbp
+                mov             rbx, 10
+                xor             r9, r9
+.limb:
+                mov             rax, [rdi + 8 * r9]
+                mov             r10, LIMB_DIGITS
+.digit:
+                xor             rdx, rdx
+                div             rbx
+                add             rdx, '0'
+                dec             rsi
+                mov             [rsi], dl
+                cmp             r9, r8
+                je              .top_digit
+                dec             r10
+                jnz             .digit
+                inc             r9
+                jmp             .limb
+
+.top_digit:
+                or              rax, rax
+                jnz             .digit
+
+                mov             rdx, rbp
+                sub             rdx, rsi
+                call            print_string
+
+                mov             rsp, rbp
+                pop             rcx
+                pop             rax
+                ret
+%endif
+
+; read one char from stdin through input_buf
 ; result:
 ;    rax == -1 if error occurs
 ;    rax \in [0; 255] if OK
@@ -251,25 +507,60 @@ read_char:
                 push            rcx
                 push            rdi
 
-                sub             rsp, 1
-                xor             rax, rax
-                xor             rdi, rdi
-                mov             rsi, rsp
-                mov             rdx, 1
-                syscall
-
-                cmp             rax, 1
-                jne             .error
-                xor             rax, rax
-                mov             al, [rsp]
-                add             rsp, 1
+                mov             rcx, [input_pos]
+                cmp             rcx, [input_len]
+                jb              .ready
+                call            fill_input
+                or              rax, rax
+                jz              .error
+                mov             rcx, [input_pos]
+.ready:
+                movzx           rax, byte [input_buf + rcx]
+                inc             rcx
+                mov             [input_pos], rcx
 
                 pop             rdi
                 pop             rcx
                 ret
 .error:
                 mov             rax, -1
-                add             rsp, 1
+                pop             rdi
+                pop             rcx
+                ret
+
+; moves unread input to the start of input_buf and reads more from stdin
+; result:
+;    rax -- number of unread bytes, 0 if input is over
+fill_input:
+                push            rcx
+                push            rdi
+                push            rsi
+                push            rdx
+
+                mov             rsi, [input_pos]
+                mov             rcx, [input_len]
+                sub             rcx, rsi
+                mov             [input_len], rcx
+                mov             qword [input_pos], 0
+                add             rsi, input_buf
+                mov             rdi, input_buf
+                rep movsb
+
+                xor             rax, rax
+                xor             rdi, rdi
+                mov             rsi, input_buf
+                add             rsi, [input_len]
+                mov             rdx, INPUT_SIZE
+                sub             rdx, [input_len]
+                syscall
+                cmp             rax, 0
+                jle             .done
+                add             [input_len], rax
+.done:
+                mov             rax, [input_len]
+
+                pop             rdx
+                pop             rsi
                 pop             rdi
                 pop             rcx
                 ret
@@ -289,6 +580,9 @@ write_char:
                 ret
 
 exit:
+%ifdef PROFILE
+                call            print_profile
+%endif
                 mov             rax, 60
                 xor             rdi, rdi
                 syscall
@@ -307,10 +601,6 @@ print_string:
                 ret
 
 
-                section         .rodata
-invalid_char_msg:
-                db              "Invalid character: "
-invalid_char_msg_size: equ             $ - invalid_char_msg
 
 ;compares two long numbers
 ;   rdi -- address of num1 (long number)
@@ -351,6 +641,7 @@ comp_long_long:
 
 
 
+%ifndef DECIMAL
 ; subtracts two long number
 ;    rdi -- address of num1 (long number)
 ;    rsi -- address of num2 (long number)
@@ -387,3 +678,145 @@ sub_long_long:
                 pop             rsi
                 pop             rdi
                 ret
+%else
+; subtracts two long number in decimal limbs
+;    rdi -- address of num1 (long number)
+;    rsi -- address of num2 (long number)
+;    rcx -- length of long numbers in qwords
+; result:
+;    [rdi] = |[rdi] - [rsi]|
+sub_long_long:
+                call            comp_long_long
+                push            rdi
+                push            rsi
+                push            rcx
+                push            r8
+                push            r9
+
+                mov             r8, LIMB_BASE
+                xor             rdx, rdx
+.loop:
+                mov             rax, [rdi]
+                sub             rax, [rsi]
+                sub             rax, rdx
+                mov             rdx, rax
+                sar             rdx, 63
+                mov             r9, r8
+                and             r9, rdx
+                add             rax, r9
+                neg             rdx
+                mov             [rdi], rax
+                lea             rsi, [rsi + 8]
+                lea             rdi, [rdi + 8]
+                dec             rcx
+                jnz             .loop
+
+                pop             r9
+                pop             r8
+                pop             rcx
+                pop             rsi
+                pop             rdi
+                ret
+%endif
+
+%ifdef PROFILE
+; prints cycle counters of every phase to stderr
+print_profile:
+                mov             rsi, profile_read_msg
+                mov             rdx, profile_read_msg_size
+                mov             rax, [cycles_read]
+                call            print_counter
+                mov             rsi, profile_compute_msg
+                mov             rdx, profile_compute_msg_size
+                mov             rax, [cycles_compute]
+                call            print_counter
+                mov             rsi, profile_write_msg
+                mov             rdx, profile_write_msg_size
+                mov             rax, [cycles_write]
+                call            print_counter
+                ret
+
+; prints name and a counter to stderr
+;    rsi -- name
+;    rdx -- size of name
+;    rax -- counter (64-bit unsigned)
+print_counter:
+                push            rax
+                mov             rax, 1
+                mov             rdi, 2
+                syscall
+                pop             rax
+
+                sub             rsp, 32
+                lea             rsi, [rsp + 32]
+                dec             rsi
+                mov             byte [rsi], 0x0a
+                mov             rbx, 10
+.loop:
+                xor             rdx, rdx
+                div             rbx
+                add             rdx, '0'
+                dec             rsi
+                mov             [rsi], dl
+                or              rax, rax
+                jnz             .loop
+
+                lea             rdx, [rsp + 32]
+                sub             rdx, rsi
+                mov             rax, 1
+                mov             rdi, 2
+                syscall
+                add             rsp, 32
+                ret
+%endif
+
+                section         .rodata align=16
+invalid_char_msg:
+                db              "Invalid character: "
+invalid_char_msg_size: equ             $ - invalid_char_msg
+%ifdef PROFILE
+profile_read_msg:
+                db              "read_long cycles: "
+profile_read_msg_size: equ             $ - profile_read_msg
+profile_compute_msg:
+                db              "sub_long_long cycles: "
+profile_compute_msg_size: equ             $ - profile_compute_msg
+profile_write_msg:
+                db              "write_long cycles: "
+profile_write_msg_size: equ             $ - profile_write_msg
+%endif
+%ifdef DECIMAL
+too_long_msg:
+                db              "Number is too long", 0x0a
+too_long_msg_size: equ             $ - too_long_msg
+%endif
+
+                align           16
+digits_zero:
+                times 16 db     '0'
+digits_nine:
+                times 16 db     9
+digits_newline:
+                times 16 db     0x0a
+digits_mul_10:
+                times 8 db      10, 1
+digits_mul_100:
+                times 4 dw      100, 1
+digits_mul_10000:
+                times 4 dw      10000, 1
+
+                section         .bss
+input_buf:
+                resb            INPUT_SIZE + 16
+input_pos:
+                resq            1
+input_len:
+                resq            1
+%ifdef PROFILE
+cycles_read:
+                resq            1
+cycles_compute:
+                resq            1
+cycles_write:
+                resq            1
+%endif
@@ -1,8 +1,14 @@
 import random
 import sys
 
+if hasattr(sys, 'set_int_max_str_digits'):
+    sys.set_int_max_str_digits(0)
+
 test_number = int(sys.argv[1])
-sort = bool(int(sys.argv[2]))
+mode = int(sys.argv[2])
+sort = mode == 1
+modmul = mode == 2
+add = mode == 3
 if test_number >= 5:
     test_number -= 4
     x = random.randint(2**(128 * (test_number - 1)) - 1, 2**(128*test_number) - 1)
@@ -23,9 +29,17 @@ elif test_number == 4:
 res = None
 if sort and (x < y):
     y, x = x, y
-    
+
+n = None
+if modmul:
+    n = random.randint(1, max(x, y, 1)) | 1
+
 if sort:
     res = x - y
+elif modmul:
+    res = x * y % n
+elif add:
+    res = x + y
 else:
     res = x * y
 
@@ -33,4 +47,7 @@ with open('output.txt', 'w') as file:
     file.write(str(res))
 
 
-print(str(x) + '\n' + str(y))
+if modmul:
+    print(str(x) + '\n' + str(y) + '\n' + str(n))
+else:
+    print(str(x) + '\n' + str(y))
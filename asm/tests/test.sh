@@ -2,15 +2,19 @@
 echo Testing $EXEC
 
 if [[ $EXEC == "mul" ]]; then
-    sort=0
+    mode=0
+elif [[ $EXEC == "modmul" ]]; then
+    mode=2
+elif [[ $EXEC == add* ]]; then
+    mode=3
 else
-    sort=1
+    mode=1
 fi
 
 time=$(date +%s%N | cut -b1-13)
 for number in {1..68}
 do
-    python3 generate.py $number $sort > input.txt
+    python3 generate.py $number $mode > input.txt
     result=$(cat input.txt | ../build/$EXEC)
     for line in $(cat output.txt) 
     do
@@ -1,24 +1,38 @@
 #ifndef BIG_INTEGER_H
 #define BIG_INTEGER_H
 
+#include <cstdint>
 #include <iostream>
-#include <functional>
+#include <utility>
 #include <vector>
 #include "buffer.h"
 
+namespace bigint_expr {
+    template <class E>
+    struct expression;
+}
+
 struct big_integer
 {
     using uint = uint32_t;
+    using limb = uint64_t;
     using storage_t = buffer;
     big_integer();
     big_integer(big_integer const& other);
+    // a moved-from value may only be assigned to or destroyed
+    big_integer(big_integer&& other) noexcept;
     big_integer(int const& val);
     big_integer(uint32_t const& val);
     ~big_integer();
     explicit big_integer(std::string const& str);
     big_integer& operator=(big_integer const& other);
+    big_integer& operator=(big_integer&& other) noexcept;
+    // evaluates a lazy expression of big_integer_expr.h into this value
+    template <class E>
+    big_integer& operator=(bigint_expr::expression<E> const& e);
 
-    big_integer operator-() const;
+    big_integer operator-() const&;
+    big_integer operator-() &&;
     big_integer operator+() const;
     big_integer operator~() const;
 
@@ -37,8 +51,12 @@ struct big_integer
     big_integer operator++(int);
     big_integer operator--(int);
 
+    // the magnitude as 32-bit words, kept for compatibility
     size_t size() const;
     uint32_t data(size_t i) const;
+    // the magnitude as native limbs
+    size_t limb_count() const;
+    limb limb_data(size_t i) const;
     bool sign() const;
 
     big_integer mult_short(uint x);
@@ -49,11 +67,13 @@ private:
     storage_t data_;
     bool sign_; // 0 if +, 1 if -
     void del_zero();
+    big_integer slice(size_t from, size_t count) const;
 
 
-    friend void translate_number(big_integer &a, size_t len);
-    friend big_integer bit_operation(big_integer const& x, big_integer const& y,
-                                     std::function<uint (uint, uint)> f);
+    template <class F>
+    friend big_integer bit_operation(big_integer const& x, big_integer const& y, F f);
+    friend int compare(big_integer const& a, big_integer const& b);
+    friend int compare_magnitude(big_integer const& a, big_integer const& b);
     friend bool operator==(big_integer const& a, big_integer const& b);
     friend bool operator<(big_integer const& a, big_integer const& b);
     friend bool operator<=(big_integer const& a, big_integer const& b);
@@ -62,21 +82,47 @@ private:
     friend bool operator!=(big_integer const& a, big_integer const& b);
 
     friend std::string to_string(big_integer a);
-    friend big_integer div_mod(big_integer &a, big_integer &b, bool mod);
-    friend uint32_t trial (big_integer &a, big_integer &b, size_t k, size_t m);
+    friend void write_decimal(big_integer x, size_t k, char* out);
+    friend big_integer parse_decimal(char const* first, char const* last);
+    friend void div_mod(big_integer const& a, big_integer const& b, big_integer& q, big_integer& r);
+    friend big_integer reciprocal(big_integer const& d);
+    friend void barrett_div_mod(big_integer const& a, big_integer const& d, big_integer const& inverse,
+                                big_integer& q, big_integer& r);
+    friend void knuth_div_mod(big_integer const& a, big_integer const& d, limb inverse,
+                              big_integer& q, big_integer& r);
+    friend void div_2n_1n(big_integer const& a, big_integer const& b, size_t n, big_integer& q, big_integer& r);
+    friend void div_3n_2n(big_integer const& a, big_integer const& b, size_t h, big_integer& q, big_integer& r);
+    friend void bz_div_mod(big_integer const& a, big_integer const& d, big_integer& q, big_integer& r);
+    friend void normalized_div_mod(big_integer const& a, big_integer const& d, limb top_inverse,
+                                   big_integer const& inverse, big_integer& q, big_integer& r);
+    friend struct big_divisor;
+    friend void sum_into(big_integer& dst, big_integer const* const* terms, bool const* negated, size_t n);
+    friend void mul_add_into(big_integer& dst, big_integer const* c, big_integer const& a, big_integer const& b,
+                             bool subtract);
     friend void print_data(big_integer x, std::string str); // need for debug only
 };
 
 big_integer operator+(big_integer a, big_integer const& b);
 big_integer operator-(big_integer a, big_integer const& b);
 big_integer operator*(big_integer a, big_integer const& b);
+// a temporary right operand lends its storage to the result
+big_integer operator+(big_integer const& a, big_integer&& b);
+big_integer operator+(big_integer&& a, big_integer&& b);
+big_integer operator-(big_integer const& a, big_integer&& b);
+big_integer operator-(big_integer&& a, big_integer&& b);
+big_integer operator*(big_integer const& a, big_integer&& b);
+big_integer operator*(big_integer&& a, big_integer&& b);
 big_integer operator/(big_integer a, big_integer const& b);
 big_integer operator%(big_integer a, big_integer const& b);
 big_integer operator<<(big_integer a, int b);
 big_integer operator>>(big_integer a, int b);
-big_integer operator&(big_integer a, big_integer const& b);
-big_integer operator|(big_integer a, big_integer const& b);
-big_integer operator^(big_integer a, big_integer const& b);
+big_integer operator&(big_integer const& a, big_integer const& b);
+big_integer operator|(big_integer const& a, big_integer const& b);
+big_integer operator^(big_integer const& a, big_integer const& b);
 
-big_integer abs(big_integer const& a);
+big_integer abs(big_integer a);
+// -1, 0 or 1 as a is less than, equal to or greater than b
+int compare(big_integer const& a, big_integer const& b);
+// the quotient rounded toward zero and the remainder with the sign of a, from one division
+std::pair<big_integer, big_integer> divmod(big_integer const& a, big_integer const& b);
 #endif // BIG_INTEGER_H
\ No newline at end of file
@@ -0,0 +1,187 @@
+#include "big_integer_expr.h"
+#include "limbs.h"
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+using limb = big_integer::limb;
+
+// sums of up to this many terms keep their limb pointers on the stack
+size_t const SUM_LOCAL_TERMS = 16;
+
+namespace {
+    // compares a[0, n) with b[0, m)
+    int compare(limb const* a, size_t n, limb const* b, size_t m) {
+        for (; n > m; n--) {
+            if (a[n - 1] != 0) {
+                return 1;
+            }
+        }
+        for (; m > n; m--) {
+            if (b[m - 1] != 0) {
+                return -1;
+            }
+        }
+        for (; n > 0; n--) {
+            if (a[n - 1] != b[n - 1]) {
+                return a[n - 1] < b[n - 1] ? -1 : 1;
+            }
+        }
+        return 0;
+    }
+
+    // r[0, len] = the sum of spans[0, k), each sizes[i] <= len limbs long, in one pass over the
+    // columns: a column and the carry into it fit in two limbs while there are fewer than 2^64 spans.
+    // r may be one of the spans, every column is read before it is written
+    void add_columns(limb* r, size_t len, limb const* const* spans, size_t const* sizes, size_t k) {
+        size_t common = len;
+        for (size_t t = 0; t < k; t++) {
+            common = std::min(common, sizes[t]);
+        }
+        limb carry = 0;
+        for (size_t i = 0; i < len; i++) {
+            limbs::double_limb column = carry;
+            if (i < common) {
+                for (size_t t = 0; t < k; t++) {
+                    column += spans[t][i];
+                }
+            } else {
+                for (size_t t = 0; t < k; t++) {
+                    if (i < sizes[t]) {
+                        column += spans[t][i];
+                    }
+                }
+            }
+            r[i] = static_cast<limb>(column);
+            carry = static_cast<limb>(column >> limbs::LIMB_BITS);
+        }
+        r[len] = carry;
+    }
+}
+
+// the negative terms are summed aside, or used as they are when there is only one, then the
+// positive ones are summed right into dst. A term that is dst itself has its column read before
+// that column is written, unless it is negative, then it is copied away first
+void sum_into(big_integer& dst, big_integer const* const* terms, bool const* negated, size_t n) {
+    size_t len[2] = {0, 0}, count[2] = {0, 0};
+    big_integer const* last[2] = {nullptr, nullptr};
+    for (size_t t = 0; t < n; t++) {
+        bool sign = (terms[t]->sign_ != negated[t]);
+        len[sign] = std::max(len[sign], terms[t]->data_.size());
+        count[sign]++;
+        last[sign] = terms[t];
+    }
+    size_t m = std::max(len[0], len[1]) + 1;
+
+    limb const* local_spans[SUM_LOCAL_TERMS];
+    size_t local_sizes[SUM_LOCAL_TERMS];
+    std::vector<limb const*> heap_spans;
+    std::vector<size_t> heap_sizes;
+    limb const** spans = local_spans;
+    size_t* sizes = local_sizes;
+    if (n > SUM_LOCAL_TERMS) {
+        heap_spans.resize(n);
+        heap_sizes.resize(n);
+        spans = heap_spans.data();
+        sizes = heap_sizes.data();
+    }
+    auto gather = [&](bool sign) {
+        size_t k = 0;
+        for (size_t t = 0; t < n; t++) {
+            if ((terms[t]->sign_ != negated[t]) == sign) {
+                spans[k] = terms[t]->data_.data();
+                sizes[k++] = terms[t]->data_.size();
+            }
+        }
+        return k;
+    };
+
+    big_integer::storage_t neg_sum;
+    limb const* neg = nullptr;
+    size_t neg_len = 0;
+    if (count[1] == 1 && last[1] != &dst) {
+        neg = last[1]->data_.data();
+        neg_len = len[1];
+    } else if (count[1] > 0) {
+        neg_sum = big_integer::storage_t(len[1] + 1, 0);
+        add_columns(neg_sum.data(), len[1], spans, sizes, gather(true));
+        neg = neg_sum.data();
+        neg_len = len[1] + 1;
+    }
+
+    dst.data_.resize(m, 0);
+    limb* r = dst.data_.data();
+    add_columns(r, len[0], spans, sizes, gather(false));
+    std::fill(r + len[0] + 1, r + m, 0);
+    dst.sign_ = false;
+    if (neg) {
+        if (compare(r, m, neg, neg_len) >= 0) {
+            limbs::sub_1(r + neg_len, m - neg_len, limbs::sub_n(r, r, neg, neg_len));
+        } else {
+            limbs::sub_n(r, neg, r, neg_len);
+            dst.sign_ = true;
+        }
+    }
+    dst.del_zero();
+}
+
+// a short factor is multiplied into dst limb by limb when the running value cannot change sign:
+// either the magnitudes add up, or c is longer than any product. Otherwise the product is taken
+// by the fast tiers into a fresh buffer, and c is added to or subtracted from it there
+void mul_add_into(big_integer& dst, big_integer const* c, big_integer const& a, big_integer const& b,
+                  bool subtract) {
+    big_integer const& x = (a.data_.size() >= b.data_.size() ? a : b);
+    big_integer const& y = (a.data_.size() >= b.data_.size() ? b : a);
+    size_t n = x.data_.size(), m = y.data_.size();
+    bool product_sign = ((a.sign_ != b.sign_) != subtract);
+    size_t k = (c ? c->data_.size() : 0);
+    bool c_zero = (!c || (k == 1 && c->data_[0] == 0));
+    bool c_sign = (c_zero ? product_sign : c->sign_);
+    size_t len = std::max(k, n + m) + 1;
+
+    if (m < limbs::KARATSUBA_THRESHOLD && &dst != &a && &dst != &b && (c_sign == product_sign || k > n + m)) {
+        dst.data_.resize(len, 0);
+        limb* r = dst.data_.data();
+        if (c != &dst) {
+            if (c) {
+                std::copy(c->data_.data(), c->data_.data() + k, r);
+            }
+            std::fill(r + k, r + len, 0);
+        }
+        for (size_t j = 0; j < m; j++) {
+            limb yj = y.data_[j];
+            if (c_sign == product_sign) {
+                limbs::add_1(r + j + n, len - j - n, limbs::addmul_1(r + j, x.data_.data(), n, yj));
+            } else {
+                limbs::sub_1(r + j + n, len - j - n, limbs::submul_1(r + j, x.data_.data(), n, yj));
+            }
+        }
+        dst.sign_ = c_sign;
+        dst.del_zero();
+        return;
+    }
+
+    big_integer::storage_t res(len + limbs::mul_scratch(n, m), 0);
+    limb* r = res.data();
+    limbs::mul(r, x.data_.data(), n, y.data_.data(), m, r + len);
+    std::fill(r + n + m, r + len, 0);
+    bool sign = product_sign;
+    if (!c_zero) {
+        limb const* cp = c->data_.data();
+        if (c_sign == product_sign) {
+            limbs::add_1(r + k, len - k, limbs::add_n(r, r, cp, k));
+        } else if (compare(r, n + m, cp, k) >= 0) {
+            limbs::sub_1(r + k, len - k, limbs::sub_n(r, r, cp, k));
+        } else {
+            limb borrow = limbs::sub_n(r, cp, r, k);
+            assert(borrow == 0);
+            (void) borrow;
+            sign = c_sign;
+        }
+    }
+    res.resize(len);
+    dst.data_ = std::move(res);
+    dst.sign_ = sign;
+    dst.del_zero();
+}
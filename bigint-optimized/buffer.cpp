@@ -18,7 +18,17 @@ buffer::buffer(buffer const& other) : size_(other.size_), small(other.small) {
     }
 }
 
-buffer::buffer(size_t len, uint32_t x) : size_(len), small(len <= MAX_STATIC) {
+buffer::buffer(buffer&& other) noexcept : size_(other.size_), small(other.small) {
+    if (small) {
+        std::copy(other.static_vec, other.static_vec + size_, static_vec);
+    } else {
+        dynamic_vec = other.dynamic_vec;
+        other.small = true;
+    }
+    other.size_ = 0;
+}
+
+buffer::buffer(size_t len, uint64_t x) : size_(len), small(len <= MAX_STATIC) {
     if (small) {
         std::fill(static_vec, static_vec + len, x);
     } else {
@@ -42,13 +52,44 @@ buffer& buffer::operator= (buffer const& other) {
     return *this;
 }
 
-void buffer::resize(size_t new_size, uint32_t x) {
-    while (new_size > size_) {
-        push_back(x);
+buffer& buffer::operator= (buffer&& other) noexcept {
+    if (this == &other) {
+        return *this;
     }
-    while (new_size < size_) {
-        pop_back();
+    this->~buffer();
+    size_ = other.size_;
+    small = other.small;
+    if (small) {
+        std::copy(other.static_vec, other.static_vec + size_, static_vec);
+    } else {
+        dynamic_vec = other.dynamic_vec;
+        other.small = true;
+    }
+    other.size_ = 0;
+    return *this;
+}
+
+// one step for any size change, instead of a push_back or pop_back per limb
+void buffer::resize(size_t new_size, uint64_t x) {
+    if (small && new_size <= MAX_STATIC) {
+        if (new_size > size_) {
+            std::fill(static_vec + size_, static_vec + new_size, x);
+        }
+    } else if (small) {
+        my_vector* tmp = new my_vector(static_vec, static_vec + size_);
+        try {
+            tmp->resize(new_size, x);
+        } catch (...) {
+            delete tmp;
+            throw;
+        }
+        dynamic_vec = tmp;
+        small = false;
+    } else {
+        unshare();
+        dynamic_vec->resize(new_size, x);
     }
+    size_ = new_size;
 }
 
 buffer::~buffer() {
@@ -78,7 +119,7 @@ void buffer::reverse() {
     }
 }
 
-uint32_t& buffer::operator[] (size_t i) {
+uint64_t& buffer::operator[] (size_t i) {
     if (small) {
         return static_vec[i];
     } else {
@@ -87,7 +128,7 @@ uint32_t& buffer::operator[] (size_t i) {
     }
 }
 
-uint32_t const& buffer::operator[] (size_t i) const {
+uint64_t const& buffer::operator[] (size_t i) const {
     if (small) {
         return static_vec[i];
     } else {
@@ -95,7 +136,24 @@ uint32_t const& buffer::operator[] (size_t i) const {
     }
 }
 
-void buffer::push_back(uint32_t const& x) {
+uint64_t* buffer::data() {
+    if (small) {
+        return static_vec;
+    } else {
+        unshare();
+        return dynamic_vec->data();
+    }
+}
+
+uint64_t const* buffer::data() const {
+    if (small) {
+        return static_vec;
+    } else {
+        return dynamic_vec->data();
+    }
+}
+
+void buffer::push_back(uint64_t const& x) {
     if (!small) {
         unshare();
         dynamic_vec->push_back(x);
@@ -115,7 +173,7 @@ void buffer::push_back(uint32_t const& x) {
     size_++;
 }
 
-uint32_t buffer::back() const {
+uint64_t buffer::back() const {
     assert(size_ > 0);
     if (small) {
         return static_vec[size_ - 1];
@@ -9,26 +9,31 @@
 struct buffer {
     buffer();
     buffer(buffer const& other);
-    buffer(size_t len, uint32_t x = 0);
+    // the moved-from buffer is left empty
+    buffer(buffer&& other) noexcept;
+    buffer(size_t len, uint64_t x = 0);
     buffer& operator= (buffer const& other);
-    void resize(size_t new_size, uint32_t x = 0);
+    buffer& operator= (buffer&& other) noexcept;
+    void resize(size_t new_size, uint64_t x = 0);
     ~buffer();
     bool operator== (buffer const& other) const;
     void reverse();
-    uint32_t& operator[] (size_t i);
-    uint32_t const& operator[] (size_t i) const;
-    void push_back(uint32_t const& x);
-    uint32_t back() const;
+    uint64_t& operator[] (size_t i);
+    uint64_t const& operator[] (size_t i) const;
+    uint64_t* data();
+    uint64_t const* data() const;
+    void push_back(uint64_t const& x);
+    uint64_t back() const;
     void pop_back();
     size_t size() const;
 private:
     void unshare();
     size_t size_ = 0;
-    static constexpr size_t MAX_STATIC = sizeof(my_vector*) / sizeof(uint32_t);
+    static constexpr size_t MAX_STATIC = sizeof(my_vector*) / sizeof(uint64_t);
     bool small = true;
     union {
         my_vector* dynamic_vec;
-        uint32_t static_vec[MAX_STATIC];
+        uint64_t static_vec[MAX_STATIC];
     };
 };
 
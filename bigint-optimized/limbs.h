@@ -0,0 +1,75 @@
+#ifndef BIGINT_LIMBS_H
+#define BIGINT_LIMBS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Kernels on raw little-endian limb spans, big_integer keeps signs and sizes.
+// Output spans must not overlap inputs unless a function says otherwise.
+namespace limbs {
+    using limb = uint64_t;
+    __extension__ typedef unsigned __int128 double_limb;
+    size_t const LIMB_BITS = 8 * sizeof(limb);
+
+    // below this many limbs schoolbook multiplication beats Karatsuba
+    size_t const KARATSUBA_THRESHOLD = 32;
+    // below this many limbs Karatsuba beats Toom-3
+    size_t const TOOM3_THRESHOLD = 100;
+    // from this many limbs in the shorter operand the product is taken by number-theoretic transform
+    size_t const NTT_THRESHOLD = 8192;
+
+    // r[0, n) = a[0, n) + b[0, n), returns carry; r may be a or b
+    limb add_n(limb* r, limb const* a, limb const* b, size_t n);
+    // r[0, n) = a[0, n) - b[0, n), returns borrow; r may be a or b
+    limb sub_n(limb* r, limb const* a, limb const* b, size_t n);
+    // compares a[0, n) with b[0, n) from the top limb down, returns -1, 0 or 1
+    int cmp_n(limb const* a, limb const* b, size_t n);
+    // r[0, n) += x, returns carry
+    limb add_1(limb* r, size_t n, limb x);
+    // r[0, n) -= x, returns borrow
+    limb sub_1(limb* r, size_t n, limb x);
+    // r[0, n) = a[0, n) * x, returns the high limb; r may be a
+    limb mul_1(limb* r, limb const* a, size_t n, limb x);
+    // r[0, n) = a[0, n) * x + c, returns the high limb; r may be a
+    limb mul_1c(limb* r, limb const* a, size_t n, limb x, limb c);
+    // r[0, n) += a[0, n) * x, returns the high limb
+    limb addmul_1(limb* r, limb const* a, size_t n, limb x);
+    // r[0, n) -= a[0, n) * x, returns the high limb of what was subtracted
+    limb submul_1(limb* r, limb const* a, size_t n, limb x);
+    // r[0, n) = a[0, n) << bits for 0 < bits < LIMB_BITS, returns the bits shifted out;
+    // r may be a or lie above it
+    limb lshift(limb* r, limb const* a, size_t n, unsigned bits);
+    // r[0, n) = a[0, n) >> bits for 0 < bits < LIMB_BITS, returns the bits shifted out;
+    // r may be a or lie below it
+    limb rshift(limb* r, limb const* a, size_t n, unsigned bits);
+    // q[0, n) = a[0, n) / d, returns the remainder; q may be a
+    limb divrem_1(limb* q, limb const* a, size_t n, limb d);
+    // floor((B^2 - 1) / d) - B for d with the top bit set, the inverse the kernels below take
+    limb reciprocal_1(limb d);
+    // q[0, n) = a[0, n) / (d >> shift) for d with the top bit set and inverse = reciprocal_1(d),
+    // returns the remainder; q may be a
+    limb divrem_1_preinv(limb* q, limb const* a, size_t n, limb d, unsigned shift, limb inverse);
+    // q[0, n - m) = a[0, n) / d[0, m) and a[0, m) = a[0, n) % d[0, m), n > m >= 2, for d with
+    // the top bit set and the top m limbs of a below d
+    void divrem(limb* q, limb* a, size_t n, limb const* d, size_t m);
+    // as above, with inverse = reciprocal_1(d[m - 1])
+    void divrem(limb* q, limb* a, size_t n, limb const* d, size_t m, limb inverse);
+    // r[0, n) = a[0, n) / 3, a must be divisible by 3; r may be a
+    void divexact_by3(limb* r, limb const* a, size_t n);
+
+    // number of scratch limbs mul needs for a[0, n) * b[0, m), n >= m >= 1
+    size_t mul_scratch(size_t n, size_t m);
+    // r[0, n + m) = a[0, n) * b[0, m), n >= m >= 1, using scratch[0, mul_scratch(n, m))
+    void mul(limb* r, limb const* a, size_t n, limb const* b, size_t m, limb* scratch);
+    // as above, allocating the scratch itself
+    void mul(limb* r, limb const* a, size_t n, limb const* b, size_t m);
+
+    // number of scratch limbs sqr needs for a[0, n)^2
+    size_t sqr_scratch(size_t n);
+    // r[0, 2n) = a[0, n)^2, n >= 1, using scratch[0, sqr_scratch(n))
+    void sqr(limb* r, limb const* a, size_t n, limb* scratch);
+    // as above, allocating the scratch itself
+    void sqr(limb* r, limb const* a, size_t n);
+}
+
+#endif //BIGINT_LIMBS_H
@@ -7,32 +7,41 @@
 
 my_vector::my_vector() : ref_counter(1) {}
 
-my_vector::my_vector(std::vector<uint32_t> const& vec) : ref_counter(1), vec(vec) {}
+my_vector::my_vector(std::vector<uint64_t> const& vec) : ref_counter(1), vec(vec) {}
 
 my_vector::my_vector(my_vector const& other) : ref_counter(1), vec(other.vec) {}
 
-my_vector::my_vector(uint32_t* first, uint32_t* last) : ref_counter(1), vec(std::vector<uint32_t> (first, last)) {}
+my_vector::my_vector(uint64_t* first, uint64_t* last) : ref_counter(1), vec(std::vector<uint64_t> (first, last)) {}
 
-my_vector::my_vector(size_t len, uint32_t x) : ref_counter(1), vec(std::vector<uint32_t> (len, x)) {}
+my_vector::my_vector(size_t len, uint64_t x) : ref_counter(1), vec(std::vector<uint64_t> (len, x)) {}
 
-uint32_t& my_vector::operator[] (size_t i) {
+uint64_t& my_vector::operator[] (size_t i) {
     return vec[i];
 }
 
-uint32_t const& my_vector::operator[] (size_t i) const {
+uint64_t const& my_vector::operator[] (size_t i) const {
     return vec[i];
 }
 
+uint64_t* my_vector::data() {
+    return vec.data();
+}
+
+uint64_t const* my_vector::data() const {
+    return vec.data();
+}
+
+// the counter is atomic, so copies of one buffer may live in different threads
 my_vector* my_vector::get_unique() {
-    if (ref_counter == 1) {
+    if (ref_counter.load(std::memory_order_acquire) == 1) {
         return this;
     }
-    assert(ref_counter > 0);
-    ref_counter--;
-    return new my_vector(vec);
+    my_vector* copy = new my_vector(vec);
+    delete_vector();
+    return copy;
 }
 
-void my_vector::push_back(uint32_t x) {
+void my_vector::push_back(uint64_t x) {
     vec.push_back(x);
 }
 
@@ -40,17 +49,19 @@ void my_vector::pop_back() {
     vec.pop_back();
 }
 
+void my_vector::resize(size_t len, uint64_t x) {
+    vec.resize(len, x);
+}
+
 void my_vector::delete_vector() {
     assert(ref_counter > 0);
-    if (ref_counter == 1) {
+    if (ref_counter.fetch_sub(1, std::memory_order_acq_rel) == 1) {
         delete this;
-    } else {
-        ref_counter--;
     }
 }
 
 void my_vector::inc_ref() {
-    ref_counter++;
+    ref_counter.fetch_add(1, std::memory_order_relaxed);
 }
 
 bool operator== (my_vector const& a, my_vector const& b) {
@@ -4,26 +4,30 @@
 #include <iostream>
 #include <vector>
 #include <cassert>
+#include <atomic>
 
 struct my_vector {
     my_vector();
-    explicit my_vector(std::vector<uint32_t> const& vec);
+    explicit my_vector(std::vector<uint64_t> const& vec);
     my_vector(my_vector const& other);
-    explicit my_vector(size_t len, uint32_t x = 0);
-    my_vector(uint32_t* first, uint32_t* last);
-    uint32_t& operator[] (size_t i);
-    uint32_t const& operator[] (size_t i) const;
+    explicit my_vector(size_t len, uint64_t x = 0);
+    my_vector(uint64_t* first, uint64_t* last);
+    uint64_t& operator[] (size_t i);
+    uint64_t const& operator[] (size_t i) const;
+    uint64_t* data();
+    uint64_t const* data() const;
     my_vector* get_unique();
-    void push_back(uint32_t x);
+    void push_back(uint64_t x);
     void pop_back();
+    void resize(size_t len, uint64_t x);
     void delete_vector();
     void inc_ref();
     void reverse();
     ~my_vector() = default;
     friend bool operator== (my_vector const& a, my_vector const& b);
 private:
-    size_t ref_counter;
-    std::vector<uint32_t> vec;
+    std::atomic<size_t> ref_counter;
+    std::vector<uint64_t> vec;
 };
 
 #endif //BIGINT_MY_VECTOR_H
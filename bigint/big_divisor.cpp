@@ -0,0 +1,64 @@
+#include "big_divisor.h"
+#include "limbs.h"
+#include <cassert>
+
+// divisors of this many limbs and more keep floor(B^2m / d), whose cost is paid back
+// by the first few divisions
+size_t const BARRETT_THRESHOLD = 128;
+
+big_divisor::big_divisor(big_integer const& d) : value_(d), norm_(abs(d)), shift_(0), top_inverse_(0) {
+    assert(d != 0);
+    shift_ = __builtin_clzll(norm_.data_.back());
+    norm_ <<= shift_;
+    top_inverse_ = limbs::reciprocal_1(norm_.data_.back());
+    if (norm_.limb_count() >= BARRETT_THRESHOLD) {
+        inverse_ = reciprocal(norm_);
+    }
+}
+
+big_integer const& big_divisor::value() const {
+    return value_;
+}
+
+big_integer big_divisor::div(big_integer const& a) const {
+    return divmod(a).first;
+}
+
+big_integer big_divisor::mod(big_integer const& a) const {
+    return divmod(a).second;
+}
+
+std::pair<big_integer, big_integer> big_divisor::divmod(big_integer const& a) const {
+    std::pair<big_integer, big_integer> res;
+    if (norm_.limb_count() == 1) {
+        res.first = a;
+        big_integer::limb rem = limbs::divrem_1_preinv(res.first.data_.data(), a.data_.data(), a.limb_count(),
+                                                       norm_.data_[0], shift_, top_inverse_);
+        res.second.data_[0] = rem;
+        res.first.sign_ = false;
+        res.first.del_zero();
+    } else {
+        big_integer rem;
+        normalized_div_mod(abs(a) << shift_, norm_, top_inverse_, inverse_, res.first, rem);
+        res.second = rem >> shift_;
+    }
+    if (a.sign() != value_.sign()) {
+        res.first = -res.first;
+    }
+    if (a.sign()) {
+        res.second = -res.second;
+    }
+    return res;
+}
+
+big_integer operator/(big_integer const& a, big_divisor const& d) {
+    return d.div(a);
+}
+
+big_integer operator%(big_integer const& a, big_divisor const& d) {
+    return d.mod(a);
+}
+
+std::pair<big_integer, big_integer> divmod(big_integer const& a, big_divisor const& d) {
+    return d.divmod(a);
+}
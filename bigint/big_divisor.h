@@ -0,0 +1,31 @@
+#ifndef BIG_DIVISOR_H
+#define BIG_DIVISOR_H
+
+#include <utility>
+#include "big_integer.h"
+
+// a divisor prepared once for many divisions: the magnitude normalized so its top bit is set,
+// the reciprocal of its top limb and, for long divisors, floor(B^2m / d) for Barrett reduction
+struct big_divisor
+{
+    explicit big_divisor(big_integer const& d);
+
+    big_integer const& value() const;
+
+    big_integer div(big_integer const& a) const;
+    big_integer mod(big_integer const& a) const;
+    std::pair<big_integer, big_integer> divmod(big_integer const& a) const;
+
+private:
+    big_integer value_;
+    big_integer norm_;
+    int shift_;
+    big_integer::limb top_inverse_;
+    big_integer inverse_; // zero below the Barrett threshold
+};
+
+big_integer operator/(big_integer const& a, big_divisor const& d);
+big_integer operator%(big_integer const& a, big_divisor const& d);
+std::pair<big_integer, big_integer> divmod(big_integer const& a, big_divisor const& d);
+
+#endif // BIG_DIVISOR_H
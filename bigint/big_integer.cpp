@@ -1,12 +1,32 @@
 #include "big_integer.h"
+#include "big_divisor.h"
+#include "limbs.h"
 
 #include <iostream>
 #include <cstring>
 #include <cassert>
 #include <climits>
 #include <algorithm>
-
-uint64_t const BASE = static_cast<uint64_t>(UINT_MAX) + static_cast<uint64_t>(1);
+#include <deque>
+#include <mutex>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using limbs::LIMB_BITS;
+
+// the largest power of ten that fits a limb, it has the top bit set
+big_integer::limb const DECIMAL_BASE = 10000000000000000000ULL;
+size_t const DECIMAL_DIGITS = 19;
+// numbers of this many limbs and more are converted to decimal by divide and conquer
+size_t const TO_STRING_DC_THRESHOLD = 60;
+// strings of this many digits and more are parsed by divide and conquer
+size_t const PARSE_DC_THRESHOLD = 4000;
+
+// divisors of this many limbs and more are divided recursively (Burnikel-Ziegler)
+size_t const BZ_DIV_THRESHOLD = 128;
+// reciprocals of this many limbs and more are lifted by Newton steps from a shorter one
+size_t const NEWTON_BASE_THRESHOLD = 64;
 
 big_integer::big_integer() : data_(1, 0), sign_(false) {}
 
@@ -29,36 +49,178 @@ big_integer& big_integer::operator=(big_integer const& other) {
 
 big_integer::big_integer(big_integer const& other) = default;
 
+big_integer::big_integer(big_integer&& other) noexcept = default;
+
+// swapping leaves other holding the old value, which keeps self-assignment safe
+big_integer& big_integer::operator=(big_integer&& other) noexcept {
+    data_.swap(other.data_);
+    std::swap(sign_, other.sign_);
+    return *this;
+}
+
 void big_integer::del_zero() {
-    while (size() > 1 && data_.back() == 0) {
+    while (limb_count() > 1 && data_.back() == 0) {
         data_.pop_back();
     }
+    if (limb_count() == 1 && data_[0] == 0) {
+        sign_ = false;
+    }
 }
 
-big_integer::big_integer(std::string const& str) {
-    data_.resize(1, 0);
-    sign_ = false;
-    for (size_t i = 0; i < str.length(); i++) {
-        if (str[i] > '9' || str[i] < '0') {
-            if (i == 0 && (str[i] == '-' || str[i] == '+')) {
-                continue;
-            } else {
-                throw std::invalid_argument("Invalid string");
+// limbs [from, from + count) of the magnitude as a non-negative number
+big_integer big_integer::slice(size_t from, size_t count) const {
+    big_integer res;
+    if (from < limb_count()) {
+        count = std::min(count, limb_count() - from);
+        res.data_ = storage_t(count, 0);
+        std::copy(data_.data() + from, data_.data() + from + count, res.data_.data());
+        res.del_zero();
+    }
+    return res;
+}
+
+// 10^(19 * 2^k), shared by all threads and both conversions; a deque never moves what it holds, so references
+// handed out stay valid while later powers are appended
+big_divisor const& decimal_power(size_t k) {
+    static std::deque<big_divisor> powers;
+    static std::mutex lock;
+    std::lock_guard<std::mutex> guard(lock);
+    if (powers.empty()) {
+        powers.emplace_back(big_integer("10000000000000000000"));
+    }
+    while (powers.size() <= k) {
+        big_integer const& last = powers.back().value();
+        powers.emplace_back(last * last);
+    }
+    return powers[k];
+}
+
+namespace {
+    // checks 16 characters per step: a byte is a digit iff it is neither below '0' nor above '9'
+    // as a signed char, which also rules out the bytes from 0x80 up
+    bool all_digits(char const* first, char const* last) {
+#if defined(__SSE2__)
+        __m128i const low = _mm_set1_epi8('0'), high = _mm_set1_epi8('9');
+        for (; last - first >= 16; first += 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(first));
+            __m128i bad = _mm_or_si128(_mm_cmplt_epi8(v, low), _mm_cmpgt_epi8(v, high));
+            if (_mm_movemask_epi8(bad) != 0) {
+                return false;
             }
         }
-        int x = str[i] - '0';
-        *this = mult_short(10);
-        *this += NUM[x];
+#endif
+        for (; first != last; first++) {
+            if (*first < '0' || *first > '9') {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // the value of the 16 digits at p: neighbouring lanes are merged by multiply-adds into
+    // 2-, 4- and 8-digit groups, and the last two groups are joined in a scalar register
+    uint64_t parse_16_digits(char const* p) {
+#if defined(__SSE2__)
+        __m128i v = _mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const*>(p)), _mm_set1_epi8('0'));
+        __m128i const zero = _mm_setzero_si128();
+        __m128i const tens = _mm_setr_epi16(10, 1, 10, 1, 10, 1, 10, 1);
+        __m128i pairs = _mm_packs_epi32(_mm_madd_epi16(_mm_unpacklo_epi8(v, zero), tens),
+                                        _mm_madd_epi16(_mm_unpackhi_epi8(v, zero), tens));
+        __m128i quads = _mm_madd_epi16(pairs, _mm_setr_epi16(100, 1, 100, 1, 100, 1, 100, 1));
+        quads = _mm_packs_epi32(quads, quads);
+        __m128i octs = _mm_madd_epi16(quads, _mm_setr_epi16(10000, 1, 10000, 1, 10000, 1, 10000, 1));
+        uint64_t hi = static_cast<uint32_t>(_mm_cvtsi128_si32(octs));
+        uint64_t lo = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(octs, 4)));
+        return hi * 100000000 + lo;
+#else
+        uint64_t res = 0;
+        for (size_t i = 0; i < 16; i++) {
+            res = res * 10 + static_cast<uint64_t>(p[i] - '0');
+        }
+        return res;
+#endif
     }
-    sign_ = (str[0] == '-');
+}
+
+// below the threshold the digits are read 19 at a time into one limb, which is folded in by
+// a multiply-add with 10^19; longer strings are split so that the low part has 19 * 2^k digits
+// and the halves are joined by one multiplication with the cached power
+big_integer parse_decimal(char const* first, char const* last) {
+    size_t digits = static_cast<size_t>(last - first);
+    if (digits >= PARSE_DC_THRESHOLD) {
+        size_t k = 0;
+        while ((DECIMAL_DIGITS << (k + 1)) < digits) {
+            k++;
+        }
+        char const* middle = last - (DECIMAL_DIGITS << k);
+        big_integer res = parse_decimal(first, middle);
+        res *= decimal_power(k).value();
+        res += parse_decimal(middle, last);
+        return res;
+    }
+    big_integer res;
+    res.data_ = big_integer::storage_t(digits / DECIMAL_DIGITS + 1, 0);
+    size_t n = 0;
+    size_t len = digits % DECIMAL_DIGITS;
+    if (len == 0) {
+        len = DECIMAL_DIGITS;
+    }
+    while (first != last) {
+        big_integer::limb chunk = 0, scale = 1;
+        size_t j = 0;
+        if (len == DECIMAL_DIGITS) {
+            chunk = parse_16_digits(first);
+            scale = 10000000000000000ULL;
+            j = 16;
+            first += 16;
+        }
+        for (; j < len; j++, first++) {
+            chunk = chunk * 10 + static_cast<big_integer::limb>(*first - '0');
+            scale *= 10;
+        }
+        big_integer::limb high = limbs::mul_1c(res.data_.data(), res.data_.data(), n, scale, chunk);
+        if (high != 0 || n == 0) {
+            res.data_[n++] = high;
+        }
+        len = DECIMAL_DIGITS;
+    }
+    res.del_zero();
+    return res;
+}
+
+big_integer::big_integer(std::string const& str) : sign_(false) {
+    size_t begin = (!str.empty() && (str[0] == '-' || str[0] == '+')) ? 1 : 0;
+    if (!all_digits(str.data() + begin, str.data() + str.length())) {
+        throw std::invalid_argument("Invalid string");
+    }
+    *this = parse_decimal(str.data() + begin, str.data() + str.length());
+    sign_ = (begin == 1 && str[0] == '-');
+    del_zero();
 }
 
 size_t big_integer::size() const {
-    return data_.size();
+    size_t words = LIMB_BITS / CEIL_SIZE;
+    size_t n = data_.size() * words;
+    while (n > 1 && data(n - 1) == 0) {
+        n--;
+    }
+    return n;
 }
 
 uint32_t big_integer::data(size_t i) const {
-    if (i >= size()) {
+    size_t words = LIMB_BITS / CEIL_SIZE;
+    if (i / words >= limb_count()) {
+        return 0;
+    }
+    return static_cast<uint32_t>(data_[i / words] >> (i % words * CEIL_SIZE));
+}
+
+size_t big_integer::limb_count() const {
+    return data_.size();
+}
+
+big_integer::limb big_integer::limb_data(size_t i) const {
+    if (i >= limb_count()) {
         return 0;
     }
     return data_[i];
@@ -68,9 +230,9 @@ bool big_integer::sign() const {
     return sign_;
 }
 
-big_integer abs(big_integer const& a) {
+big_integer abs(big_integer a) {
     if (a.sign()) {
-        return -a;
+        return -std::move(a);
     }
     return a;
 }
@@ -85,53 +247,39 @@ void print_data(big_integer x, std::string str) {
 }
 
 big_integer& big_integer::operator-=(big_integer const& a) {
+    if (a == NUM[0]) {
+        return *this;
+    }
     if (sign_ != a.sign_) {
         *this += (-a);
         return *this;
     }
-    if ((*this != a) && (*this < a) != sign_) {
+    if (compare_magnitude(*this, a) < 0) {
         *this = (a - *this);
         sign_ ^= true;
         return *this;
     }
-    uint x = 0;
-    for (size_t i = 0; i < a.size() || x; i++) {
-        uint y = 0;
-        if (data_[i] < a.data(i) + x) {
-            y = 1;
-        }
-        data_[i] -= (a.data(i) + x);
-        x = y;
-    }
-    assert(x == 0);
+    size_t m = std::min(a.limb_count(), limb_count());
+    limb borrow = limbs::sub_n(data_.data(), data_.data(), a.data_.data(), m);
+    borrow = limbs::sub_1(data_.data() + m, limb_count() - m, borrow);
+    assert(borrow == 0);
     del_zero();
     return *this;
 }
 
-bool sum_overflows_uint32(uint32_t a, uint32_t b) {
-    return UINT_MAX - a < b;
-}
-
 big_integer& big_integer::operator+=(big_integer const& a) {
     if (sign_ != a.sign_) {
         *this -= (-a);
         return *this;
     }
-    size_t max_size = std::max(a.size(), size());
-    uint remainder = 0;
-    for (size_t i = 0; (i < a.size() || remainder) && i < max_size; i++) {
-        if (i == size()) {
-            data_.push_back(0);
-        }
-        uint overflow = 0;
-        if (sum_overflows_uint32(data_[i], a.data(i)) || sum_overflows_uint32(data_[i] + a.data(i), remainder)) {
-            overflow = 1;
-        }
-        data_[i] += (a.data(i) + remainder);
-        remainder = overflow;
+    size_t m = a.limb_count();
+    if (limb_count() < m) {
+        data_.resize(m, 0);
     }
-    if (remainder) {
-        data_.push_back(remainder);
+    limb carry = limbs::add_n(data_.data(), data_.data(), a.data_.data(), m);
+    carry = limbs::add_1(data_.data() + m, limb_count() - m, carry);
+    if (carry) {
+        data_.push_back(carry);
     }
     return *this;
 }
@@ -160,356 +308,611 @@ big_integer big_integer::operator--(int) {
 
 big_integer big_integer::mult_short(uint32_t x) const {
     big_integer b = *this;
-    uint64_t t = 0;
-    for (size_t i = 0; i < size(); i++) {
-        uint64_t a = static_cast<uint64_t>(b.data_[i]) * static_cast<uint64_t>(x);
-        uint c = 0;
-        if (UINT_MAX - t < a % BASE) {
-            c = 1;
-        }
-        b.data_[i] = (a % BASE) + t;
-        t = a / BASE + c;
-    }
-    if (t > 0) {
-        b.data_.push_back(t);
+    limb high = limbs::mul_1(b.data_.data(), b.data_.data(), limb_count(), x);
+    if (high > 0) {
+        b.data_.push_back(high);
     }
+    b.del_zero();
     return b;
 }
 
 big_integer& big_integer::operator*=(big_integer const& a) {
-    big_integer b(*this);
-    big_integer c(b.mult_short(a.data(0)));
-    for (size_t i = 1; i < a.size(); i++) {
-        big_integer h = (b.mult_short(a.data(i)) << static_cast<int>(CEIL_SIZE * i));
-        c += h;
-    }
-    c.sign_ = (a.sign() != b.sign());
-    *this = c;
+    if (a.limb_count() == 1) {
+        limb high = limbs::mul_1(data_.data(), data_.data(), limb_count(), a.data_[0]);
+        if (high > 0) {
+            data_.push_back(high);
+        }
+        sign_ = (sign_ != a.sign_);
+        del_zero();
+        return *this;
+    }
+    // squaring has its own kernels, they skip the repeated cross products
+    if (&a == this || a.data_ == data_) {
+        size_t n = limb_count();
+        storage_t res(2 * n + limbs::sqr_scratch(n), 0);
+        limbs::sqr(res.data(), a.data_.data(), n, res.data() + 2 * n);
+        res.resize(2 * n);
+        data_.swap(res);
+        sign_ = (sign_ != a.sign_);
+        del_zero();
+        return *this;
+    }
+    storage_t const& x = (limb_count() >= a.limb_count() ? data_ : a.data_);
+    storage_t const& y = (limb_count() >= a.limb_count() ? a.data_ : data_);
+    size_t n = x.size(), m = y.size();
+    // the product and the scratch of the fast tiers share one allocation
+    storage_t res(n + m + limbs::mul_scratch(n, m), 0);
+    limbs::mul(res.data(), x.data(), n, y.data(), m, res.data() + n + m);
+    res.resize(n + m);
+    data_.swap(res);
+    sign_ = (sign_ != a.sign_);
+    del_zero();
     return *this;
 }
 
 void big_integer::div_mod_short(uint b, bool mod) {
-    big_integer ans(0);
-    uint64_t cur = data_.back();
-    size_t j = size() - 1;
-    if (cur < b) {
-        if (size() == 1) {
-            if (!mod) {
-                *this = NUM[0];
-            }
-            return;
+    storage_t q(limb_count());
+    limb rem = limbs::divrem_1(q.data(), data_.data(), limb_count(), b);
+    if (mod) {
+        data_ = storage_t(1, rem);
+    } else {
+        data_.swap(q);
+    }
+    sign_ = false;
+    del_zero();
+}
+
+// floor(B^2m / d) for a normalized d of m limbs. A plain division inverts the top k limbs
+// of d, then every Newton step x += x * (B^2n - d_n * x) / B^2n lifts the reciprocal of the
+// top k limbs d_k to that of the top n <= 2k - 1 limbs d_n, touching only d_n and the top
+// limbs of the residual, so the steps cost a couple of multiplications of the full size
+// together. The guard limb keeps x within a few units below B^2n / d_n all the way up,
+// and the residual of the last step gives the one of the result for the final correction
+big_integer reciprocal(big_integer const& d) {
+    size_t m = d.limb_count();
+    size_t steps[CHAR_BIT * sizeof(size_t)];
+    size_t count = 0;
+    size_t k = m;
+    while (k >= NEWTON_BASE_THRESHOLD) {
+        steps[count++] = k;
+        k = k / 2 + 1;
+    }
+    big_integer x = (NUM[1] << static_cast<int>(2 * k * LIMB_BITS)) / d.slice(m - k, k);
+    if (count == 0) {
+        return x;
+    }
+    big_integer t, step;
+    for (size_t i = count; i > 0; i--) {
+        size_t n = steps[i - 1];
+        t = (NUM[1] << static_cast<int>((n + k) * LIMB_BITS)) - d.slice(m - n, n) * x;
+        step = (x * (t >> static_cast<int>((k - 1) * LIMB_BITS))) >> static_cast<int>((k + 1) * LIMB_BITS);
+        x = (x << static_cast<int>((n - k) * LIMB_BITS)) + step;
+        if (i > 1) {
+            k = n;
         }
-        cur <<= CEIL_SIZE;
-        cur += data_[j - 1];
-        j--;
-    }
-    while (true) {
-        ans.data_.push_back(cur / static_cast<uint64_t>(b));
-        cur %= static_cast<uint64_t>(b);
-        if (j== 0) {
-            break;
+    }
+    big_integer e = (t << static_cast<int>((m - k) * LIMB_BITS)) - d * step;
+    while (e.sign_) {
+        --x;
+        e += d;
+    }
+    while (e >= d) {
+        ++x;
+        e -= d;
+    }
+    return x;
+}
+
+// a = q * d + r for a normalized d of m limbs and inverse = floor(B^2m / d); a is consumed
+// m limbs at a time, so every step is a 2m / m Barrett division whose estimate
+// floor(floor(c / B^(m - 1)) * inverse / B^(m + 1)) is at most two short of the quotient.
+// Each step's quotient is below B^m and goes straight into its own m limbs of q
+void barrett_div_mod(big_integer const& a, big_integer const& d, big_integer const& inverse,
+                     big_integer& q, big_integer& r) {
+    size_t m = d.limb_count();
+    size_t chunks = (a.limb_count() + m - 1) / m;
+    big_integer::storage_t res(chunks * m, 0);
+    r = NUM[0];
+    for (size_t i = chunks; i > 0; i--) {
+        big_integer c = (r << static_cast<int>(m * LIMB_BITS)) + a.slice((i - 1) * m, m);
+        big_integer qc = ((c >> static_cast<int>((m - 1) * LIMB_BITS)) * inverse) >>
+                static_cast<int>((m + 1) * LIMB_BITS);
+        r = c - qc * d;
+        while (r >= d) {
+            ++qc;
+            r -= d;
         }
-        cur <<= CEIL_SIZE;
-        cur += data_[j - 1];
-        j--;
+        std::copy(qc.data_.data(), qc.data_.data() + qc.limb_count(), res.data() + (i - 1) * m);
     }
-    std::reverse(ans.data_.begin(), ans.data_.end());
-    *this = mod ? big_integer(static_cast<uint>(cur)) : ans;
-    del_zero();
+    q.data_.swap(res);
+    q.sign_ = false;
+    q.del_zero();
+}
+
+// schoolbook division of a by a normalized d of at least two limbs (Knuth, TAOCP 4.3.1 D),
+// run in place on a copy of a with one zero limb on top; inverse is reciprocal_1 of d's top limb
+void knuth_div_mod(big_integer const& a, big_integer const& d, big_integer::limb inverse,
+                   big_integer& q, big_integer& r) {
+    if (compare_magnitude(a, d) < 0) {
+        q = NUM[0];
+        r = a;
+        return;
+    }
+    size_t n = a.limb_count(), m = d.limb_count();
+    big_integer::storage_t rem(n + 1, 0);
+    std::copy(a.data_.data(), a.data_.data() + n, rem.data());
+    q.data_ = big_integer::storage_t(n + 1 - m, 0);
+    q.sign_ = false;
+    limbs::divrem(q.data_.data(), rem.data(), n + 1, d.data_.data(), m, inverse);
+    q.del_zero();
+    rem.resize(m);
+    r.data_.swap(rem);
+    r.sign_ = false;
+    r.del_zero();
+}
+
+// a = q * b + r for a < b * B^n and a normalized b of n limbs (Burnikel and Ziegler, 1998):
+// the top three and then the bottom three of a's four halves are divided by b in 3n/2n steps
+void div_2n_1n(big_integer const& a, big_integer const& b, size_t n, big_integer& q, big_integer& r) {
+    if (n % 2 == 1 || n < BZ_DIV_THRESHOLD) {
+        knuth_div_mod(a, b, limbs::reciprocal_1(b.data_.back()), q, r);
+        return;
+    }
+    size_t h = n / 2;
+    big_integer q1, r1;
+    div_3n_2n(a.slice(h, 3 * h), b, h, q1, r1);
+    div_3n_2n((r1 << static_cast<int>(h * LIMB_BITS)) + a.slice(0, h), b, h, q, r);
+    q += q1 << static_cast<int>(h * LIMB_BITS);
+}
+
+// a = q * b + r for a < b * B^h and a normalized b of 2h limbs: the quotient is estimated
+// by dividing the top 2h limbs of a by the top half of b, which is at most two too large
+void div_3n_2n(big_integer const& a, big_integer const& b, size_t h, big_integer& q, big_integer& r) {
+    int half = static_cast<int>(h * LIMB_BITS);
+    big_integer b1 = b.slice(h, h), a12 = a.slice(h, 2 * h);
+    if (a.slice(2 * h, h) < b1) {
+        div_2n_1n(a12, b1, h, q, r);
+    } else {
+        q = (NUM[1] << half) - 1;
+        r = a12 - (b1 << half) + b1;
+    }
+    r = (r << half) + a.slice(0, h) - q * b.slice(0, h);
+    while (r.sign_) {
+        --q;
+        r += b;
+    }
+}
+
+// pads a normalized d to n = k * 2^j limbs with k below the threshold so that the recursion
+// halves evenly down to Knuth's base case, then divides a by n-limb blocks from the top
+void bz_div_mod(big_integer const& a, big_integer const& d, big_integer& q, big_integer& r) {
+    size_t m = d.limb_count(), k = m, j = 0;
+    while (k >= BZ_DIV_THRESHOLD) {
+        k = (k + 1) / 2;
+        j++;
+    }
+    size_t n = k << j;
+    int pad = static_cast<int>((n - m) * LIMB_BITS);
+    big_integer x = a << pad, y = d << pad;
+    size_t blocks = (x.limb_count() + n - 1) / n;
+    big_integer::storage_t res(blocks * n, 0);
+    r = NUM[0];
+    for (size_t i = blocks; i > 0; i--) {
+        big_integer qb;
+        div_2n_1n((r << static_cast<int>(n * LIMB_BITS)) + x.slice((i - 1) * n, n), y, n, qb, r);
+        std::copy(qb.data_.data(), qb.data_.data() + qb.limb_count(), res.data() + (i - 1) * n);
+    }
+    q.data_.swap(res);
+    q.sign_ = false;
+    q.del_zero();
+    r >>= pad;
 }
 
-uint32_t trial(big_integer const& a, big_integer const& b, size_t k, size_t m) {
-    assert(m + k - 2 >= 0);
-    if (a.data(m + k) > b.data(m - 1) ||
-    (a.data(m + k) == b.data(m - 1) && a.data(m + k - 1) >= b.data(m - 2))) {
-        return UINT_MAX;
+// a = q * d + r for a normalized d of at least two limbs, top_inverse = reciprocal_1 of its top
+// limb and inverse = floor(B^2m / d) if the caller has it at hand, zero otherwise
+void normalized_div_mod(big_integer const& a, big_integer const& d, big_integer::limb top_inverse,
+                        big_integer const& inverse, big_integer& q, big_integer& r) {
+    if (inverse != NUM[0]) {
+        barrett_div_mod(a, d, inverse, q, r);
+    } else if (d.limb_count() >= BZ_DIV_THRESHOLD) {
+        bz_div_mod(a, d, q, r);
+    } else {
+        knuth_div_mod(a, d, top_inverse, q, r);
     }
-    unsigned __int128 a3 = (((static_cast<unsigned __int128>(a.data(m + k)) << a.CEIL_SIZE) +
-            static_cast<unsigned __int128>(a.data(m + k - 1))) << a.CEIL_SIZE) +
-            static_cast<unsigned __int128>(a.data(m + k - 2));
-    unsigned __int128 b2 = (static_cast<unsigned __int128>(b.data(m - 1)) << a.CEIL_SIZE) +
-            static_cast<unsigned __int128>(b.data(m - 2));
-    return std::min(UINT_MAX, static_cast<uint32_t>(a3 / b2));
 }
 
-big_integer div_mod(big_integer &a, big_integer &b, bool mod) {
+// q = |a| / |b| and r = |a| % |b|, the signs of a and b are ignored
+void div_mod(big_integer const& a, big_integer const& b, big_integer& q, big_integer& r) {
     assert(b != NUM[0]);
-    if (a == NUM[0]) {
-        return a;
-    }
-    if (a < b) {
-        return mod ? a : NUM[0];
-    }
-    if (b.size() == 1) {
-        big_integer ans = a;
-        ans.div_mod_short(b.data(0), mod);
-        return ans;
-    }
-    assert(b.size());
-    uint32_t shift = BASE / static_cast<uint64_t>(b.data_.back() + 1); // 0;
-    big_integer r(a * shift), d(b * shift);
-    size_t n = a.size(), m = b.size();
-    assert(2 <= m && m <= n);
-    big_integer q(0);
-    q.data_.pop_back();
-    for (int k = static_cast<int>(n - m); k >= 0; k--) {
-        if (r == NUM[0]) {
-            q.data_.push_back(0);
-            continue;
-        }
-        uint32_t qt = trial(r, d, k, m);
-        big_integer dq = d * qt;
-        if (r  < (dq << static_cast<size_t>(k * r.CEIL_SIZE))) {
-            qt--;
-            assert(dq >= d);
-            dq -= d;
-        }
-        q.data_.push_back(qt);
-        big_integer tmp(dq << static_cast<size_t>(k * dq.CEIL_SIZE));
-        assert(r >= tmp);
-        r -= tmp;
+    if (compare_magnitude(a, b) < 0) {
+        r = a;
+        r.sign_ = false;
+        q = NUM[0];
+        return;
+    }
+    if (b.limb_count() == 1) {
+        big_integer::limb d = b.data_[0];
+        q = a;
+        q.sign_ = false;
+        big_integer::limb rem = limbs::divrem_1(q.data_.data(), q.data_.data(), q.limb_count(), d);
+        q.del_zero();
+        r = big_integer();
+        r.data_[0] = rem;
+        return;
+    }
+    int shift = __builtin_clzll(b.data_.back());
+    big_integer x(a << shift), d(b << shift), rem;
+    x.sign_ = false;
+    d.sign_ = false;
+    normalized_div_mod(x, d, limbs::reciprocal_1(d.data_.back()), NUM[0], q, rem);
+    r = rem >> shift;
+}
+
+std::pair<big_integer, big_integer> divmod(big_integer const& a, big_integer const& b) {
+    std::pair<big_integer, big_integer> res;
+    div_mod(a, b, res.first, res.second);
+    if (a.sign() != b.sign()) {
+        res.first = -res.first;
     }
-    std::reverse(q.data_.begin(), q.data_.end());
-    q.del_zero();
-    if (mod) {
-        r.div_mod_short(shift, false);
-        return r;
+    if (a.sign()) {
+        res.second = -res.second;
     }
-    return q;
+    return res;
 }
 
 big_integer& big_integer::operator/=(big_integer const& a) {
-    big_integer b = *this;
-    big_integer x = abs(b), y = abs(a);
-    *this = div_mod(x, y, false);
-    sign_ = (b.sign_ != a.sign_);
+    *this = divmod(*this, a).first;
     return *this;
 }
 
 big_integer& big_integer::operator%=(big_integer const& a) {
-    big_integer b = *this;
-    big_integer x = abs(b), y = abs(a);
-    *this = div_mod(x, y, true);
-    sign_ = b.sign_;
+    *this = divmod(*this, a).second;
     return *this;
 }
 
+// the destination is sized once; whole limbs move up by memmove, or together with the
+// remaining bits by one funnel shift from the top down
 big_integer& big_integer::operator<<=(int shift) {
-    if (shift == 0) {
-        return *this;
-    }
     assert(shift >= 0);
-    if (*this == NUM[0]) {
+    if (shift == 0 || *this == NUM[0]) {
         return *this;
     }
-    int n = shift / CEIL_SIZE;
-    for (int i = 0; i < n; i++) {
-        data_.push_back(0);
-    }
-    for (int i = (int)size() - 1; i >= n; i--) {
-        data_[i] = data_[i - n];
-    }
-    for (int i = 0; i < n; i++) {
-        data_[i] = 0;
-    }
-    n = shift % CEIL_SIZE;
-    if (n) {
-        if ((UINT_MAX >> n) < data_.back()) {
-            data_.push_back(0);
-        }
-        uint x = 0;
-        for (size_t i = 0; i < size(); i++) {
-            uint y = (data_[i] >> (CEIL_SIZE - n));
-            data_[i] = (data_[i] << (uint)n) + x;
-            x = y;
-        }
-    }
+    size_t n = limb_count(), k = static_cast<size_t>(shift) / LIMB_BITS;
+    unsigned bits = static_cast<unsigned>(shift) % LIMB_BITS;
+    data_.resize(n + k + 1, 0);
+    limb* d = data_.data();
+    if (bits) {
+        d[n + k] = limbs::lshift(d + k, d, n, bits);
+    } else {
+        std::memmove(d + k, d, n * sizeof(limb));
+        d[n + k] = 0;
+    }
+    std::fill(d, d + k, 0);
+    del_zero();
     return *this;
 }
 
+// rounds toward minus infinity: a negative value whose shifted out bits are not all zero
+// ends up one further from zero than its shifted magnitude
 big_integer& big_integer::operator>>=(int shift) {
     assert(shift >= 0);
-    if (*this == NUM[0]) {
+    if (shift == 0) {
         return *this;
     }
-    size_t n = std::min(size(), shift / CEIL_SIZE);
-    for (size_t i = 0; i < size() - n; i++) {
-        data_[i] = data_[i + n];
-    }
-    for (size_t i = 0; i < n; i++) {
-        data_.pop_back();
+    size_t n = limb_count(), k = static_cast<size_t>(shift) / LIMB_BITS;
+    unsigned bits = static_cast<unsigned>(shift) % LIMB_BITS;
+    if (k >= n) {
+        data_.resize(1);
+        data_[0] = (sign_ ? 1 : 0);
+        return *this;
     }
-    n = shift % CEIL_SIZE;
-    if (n) {
-        uint x = 0;
-        for (int i = (int)size() - 1; i >= 0; i--) {
-            uint y = (data_[i] << (CEIL_SIZE - n));
-            data_[i] = (data_[i] >> n) + x;
-            x = y;
+    limb* d = data_.data();
+    bool inexact = false;
+    if (sign_) {
+        for (size_t i = 0; i < k && !inexact; i++) {
+            inexact = (d[i] != 0);
         }
     }
-    if (sign_ ) {
-        *this -= NUM[1];
+    if (bits) {
+        inexact |= (limbs::rshift(d, d + k, n - k, bits) != 0);
+    } else if (k) {
+        std::memmove(d, d + k, (n - k) * sizeof(limb));
+    }
+    data_.resize(n - k);
+    if (sign_ && inexact) {
+        limb carry = limbs::add_1(data_.data(), n - k, 1);
+        if (carry) {
+            data_.push_back(carry);
+        }
     }
     del_zero();
     return *this;
 }
 
-void translate_number(big_integer &a, size_t len) {
-    while (a.size() < len) {
-        a.data_.push_back(0);
-    }
-    if (a.sign()) {
-        for (auto &i : a.data_) {
-            i = ~i;
+// f applied to the two's complement limbs of x and y, where a negative value with magnitude m
+// reads as (m ^ ~0) + 1 and the sign fills the limbs above. The +1 only carries through the low
+// zero limbs, as does the same conversion of a negative result back to a magnitude, so once all
+// three carries are spent the rest is a plain loop of xors that the compiler can vectorize
+template <class F>
+big_integer bit_operation(big_integer const& x, big_integer const& y, F f) {
+    using limb = big_integer::limb;
+    size_t nx = x.limb_count(), ny = y.limb_count(), len = std::max(nx, ny);
+    limb mx = (x.sign_ ? ~static_cast<limb>(0) : 0), my = (y.sign_ ? ~static_cast<limb>(0) : 0);
+    limb mr = f(mx, my);
+    big_integer res;
+    res.data_ = big_integer::storage_t(len + 1, 0);
+    limb* r = res.data_.data();
+    limb const* px = x.data_.data();
+    limb const* py = y.data_.data();
+    limb cx = mx & 1, cy = my & 1, cr = mr & 1;
+    size_t i = 0;
+    for (; i < len && (cx | cy | cr); i++) {
+        limb a = (i < nx ? px[i] : 0) ^ mx, b = (i < ny ? py[i] : 0) ^ my;
+        a += cx;
+        cx &= (a == 0);
+        b += cy;
+        cy &= (b == 0);
+        limb c = (f(a, b) ^ mr) + cr;
+        cr &= (c == 0);
+        r[i] = c;
+    }
+    size_t m = std::min(nx, ny);
+    for (; i < m; i++) {
+        r[i] = f(px[i] ^ mx, py[i] ^ my) ^ mr;
+    }
+    for (; i < nx; i++) {
+        r[i] = f(px[i] ^ mx, my) ^ mr;
+    }
+    for (; i < ny; i++) {
+        r[i] = f(mx, py[i] ^ my) ^ mr;
+    }
+    r[len] = cr;
+    res.sign_ = (mr != 0);
+    res.del_zero();
+    return res;
+}
+
+namespace {
+    struct bit_and {
+        big_integer::limb operator()(big_integer::limb a, big_integer::limb b) const {
+            return a & b;
         }
-        a--;
-    }
-}
+    };
 
-big_integer bit_operation(big_integer const& x, big_integer const& y, std::function<uint(uint, uint)> f) {
-    size_t len = std::max(x.size(), y.size());
-    big_integer a(x), b(y);
-    translate_number(a, len);
-    translate_number(b, len);
-    big_integer ans;
-    ans.data_.resize(len);
-    for (size_t i = 0; i < len; i++) {
-        ans.data_[i] = f(a.data_[i], b.data_[i]);
-    }
-    ans.del_zero();
-    ans.sign_ = f(x.sign_, y.sign_);
-    translate_number(ans, len);
-    ans.del_zero();
-    return ans;
+    struct bit_or {
+        big_integer::limb operator()(big_integer::limb a, big_integer::limb b) const {
+            return a | b;
+        }
+    };
+
+    struct bit_xor {
+        big_integer::limb operator()(big_integer::limb a, big_integer::limb b) const {
+            return a ^ b;
+        }
+    };
 }
 
 big_integer& big_integer::operator&=(big_integer const& a) {
-    *this = bit_operation(*this, a, [] (uint a, uint b) {return a & b;});
+    *this = bit_operation(*this, a, bit_and());
     return *this;
 }
 
 big_integer& big_integer::operator|=(big_integer const& a) {
-    *this = bit_operation(*this, a, [] (uint a, uint b) {return a | b;});
+    *this = bit_operation(*this, a, bit_or());
     return *this;
 }
 
 big_integer& big_integer::operator^=(big_integer const& a) {
-    *this = bit_operation(*this, a, [] (uint a, uint b) {return a ^ b;});
+    *this = bit_operation(*this, a, bit_xor());
     return *this;
 }
 
 big_integer operator+(big_integer a, big_integer const& b) {
-    return a += b;
+    a += b;
+    return a;
 }
 
 big_integer operator-(big_integer a, big_integer const& b) {
-    return a -= b;
+    a -= b;
+    return a;
 }
 
 big_integer operator*(big_integer a, big_integer const& b) {
-    return a *= b;
+    a *= b;
+    return a;
+}
+
+big_integer operator+(big_integer const& a, big_integer&& b) {
+    b += a;
+    return std::move(b);
+}
+
+big_integer operator+(big_integer&& a, big_integer&& b) {
+    a += b;
+    return std::move(a);
+}
+
+big_integer operator-(big_integer const& a, big_integer&& b) {
+    b -= a;
+    return -std::move(b);
+}
+
+big_integer operator-(big_integer&& a, big_integer&& b) {
+    a -= b;
+    return std::move(a);
+}
+
+big_integer operator*(big_integer const& a, big_integer&& b) {
+    b *= a;
+    return std::move(b);
+}
+
+big_integer operator*(big_integer&& a, big_integer&& b) {
+    a *= b;
+    return std::move(a);
 }
 
 big_integer operator/(big_integer a, big_integer const& b) {
-    return a /= b;
+    a /= b;
+    return a;
 }
 
 big_integer operator%(big_integer a, big_integer const& b) {
-    return a %= b;
+    a %= b;
+    return a;
 }
 
 big_integer operator<<(big_integer a, int b) {
-    return a <<= b;
+    a <<= b;
+    return a;
 }
 
 big_integer operator>>(big_integer a, int b) {
-    return a >>= b;
+    a >>= b;
+    return a;
 }
 
-big_integer operator&(big_integer a, big_integer const& b) {
-    return a &= b;
+// the result is built in a fresh buffer, so neither operand is copied
+big_integer operator&(big_integer const& a, big_integer const& b) {
+    return bit_operation(a, b, bit_and());
 }
 
-big_integer operator|(big_integer a, big_integer const& b) {
-    return a |= b;
+big_integer operator|(big_integer const& a, big_integer const& b) {
+    return bit_operation(a, b, bit_or());
 }
 
-big_integer operator^(big_integer a, big_integer const& b) {
-    return a ^= b;
+big_integer operator^(big_integer const& a, big_integer const& b) {
+    return bit_operation(a, b, bit_xor());
 }
 
-big_integer big_integer::operator-() const {
+big_integer big_integer::operator-() const& {
     big_integer b = *this;
     b.sign_ ^= true;
+    b.del_zero();
     return b;
 }
 
+big_integer big_integer::operator-() && {
+    sign_ ^= true;
+    del_zero();
+    return std::move(*this);
+}
+
 big_integer big_integer::operator+() const {
     return *this;
 }
 
+// ~x = -x - 1, so the magnitude moves by one towards or away from zero
 big_integer big_integer::operator~() const {
-    return (-*this - NUM[1]);
+    big_integer res = *this;
+    if (sign_) {
+        limbs::sub_1(res.data_.data(), res.limb_count(), 1);
+    } else {
+        limb carry = limbs::add_1(res.data_.data(), res.limb_count(), 1);
+        if (carry) {
+            res.data_.push_back(carry);
+        }
+    }
+    res.sign_ = !sign_;
+    res.del_zero();
+    return res;
+}
+
+// divides a[0, n) in place by 10^19 until it is zero, every remainder is written as the next
+// 19 digits to the left of end
+void write_chunks(big_integer::limb* a, size_t n, char* end) {
+    static big_integer::limb const inverse = limbs::reciprocal_1(DECIMAL_BASE);
+    while (n > 0 && a[n - 1] == 0) {
+        n--;
+    }
+    while (n > 0) {
+        big_integer::limb chunk = limbs::divrem_1_preinv(a, a, n, DECIMAL_BASE, 0, inverse);
+        if (a[n - 1] == 0) {
+            n--;
+        }
+        for (size_t i = 0; i < DECIMAL_DIGITS; i++) {
+            *--end = static_cast<char>('0' + chunk % 10);
+            chunk /= 10;
+        }
+    }
 }
 
+// writes a non-negative x < 10^(19 * 2^(k + 1)) into out as exactly 19 * 2^(k + 1) digits,
+// out comes filled with zeros
+void write_decimal(big_integer x, size_t k, char* out) {
+    size_t half = DECIMAL_DIGITS << k;
+    if (k == 0 || x.limb_count() < TO_STRING_DC_THRESHOLD) {
+        write_chunks(x.data_.data(), x.limb_count(), out + 2 * half);
+        return;
+    }
+    std::pair<big_integer, big_integer> qr = divmod(x, decimal_power(k));
+    write_decimal(qr.first, k - 1, out);
+    write_decimal(qr.second, k - 1, out + half);
+}
+
+// small numbers go by chunks of 19 digits, large ones are split in halves by the power of ten
+// closest to their square root, so the conversion costs a few divisions of each size
 std::string to_string (big_integer x) {
-    if (x < NUM[0]) {
-        return "-" + to_string(-x);
-    }
-    std::string str;
-    while (x > NUM[0]) {
-        big_integer r = x;
-        r.div_mod_short(10, true);
-        int n = 0;
-        if (r > NUM[0]) {
-            n = r.data_[0];
+    size_t n = x.limb_count();
+    size_t k = 0;
+    if (n >= TO_STRING_DC_THRESHOLD) {
+        while (compare_magnitude(x, decimal_power(k + 1).value()) >= 0) {
+            k++;
+        }
+    } else {
+        // a limb holds 19.27 digits, so there are at most n + n / 32 + 1 chunks
+        while ((DECIMAL_DIGITS << (k + 1)) < (n + n / 32 + 1) * DECIMAL_DIGITS) {
+            k++;
         }
-        x.div_mod_short(10, false);
-        str.push_back(n + '0');
     }
-    if (str.empty()) {
-        str = "0";
+    bool negative = (x.sign_ && x != NUM[0]);
+    std::string str((DECIMAL_DIGITS << (k + 1)) + 1, '0');
+    write_decimal(abs(x), k, &str[1]);
+    size_t pos = std::min(str.find_first_not_of('0', 1), str.size() - 1);
+    if (negative) {
+        str[--pos] = '-';
     }
-    std::reverse(str.begin(), str.end());
+    str.erase(0, pos);
     return str;
 }
 
+// zero is kept without a sign, so values of different signs differ and the magnitudes
+// decide the rest in one scan from the top limb
+int compare(big_integer const& a, big_integer const& b) {
+    if (a.sign_ != b.sign_) {
+        return a.sign_ ? -1 : 1;
+    }
+    int res = compare_magnitude(a, b);
+    return a.sign_ ? -res : res;
+}
+
+int compare_magnitude(big_integer const& a, big_integer const& b) {
+    if (a.limb_count() != b.limb_count()) {
+        return a.limb_count() < b.limb_count() ? -1 : 1;
+    }
+    return limbs::cmp_n(a.data_.data(), b.data_.data(), a.limb_count());
+}
+
 bool operator==(big_integer const& a, big_integer const& b) {
-    return ((a.sign_ == b.sign_ && a.data_ == b.data_) ||
-            (a.data_ == b.data_ && a.data_ == NUM[0].data_));
+    return compare(a, b) == 0;
 }
 
 bool operator<(big_integer const& a, big_integer const& b) {
-    if (a == b) {
-        return false;
-    }
-    if (a.sign_ != b.sign_) {
-        return !b.sign_;
-    }
-    if (a.size() != b.size()) {
-        return (a.sign_ != (a.size() < b.size()));
-    }
-    for (int j = (int)a.size() - 1; j >= 0; j--) {
-        if (a.data_[j] != b.data_[j]) {
-            return (a.sign_ != (a.data_[j] < b.data_[j]));
-        }
-    }
-    return false;
+    return compare(a, b) < 0;
 }
 
 bool operator<=(big_integer const& a, big_integer const& b) {
-    return !(b < a);
+    return compare(a, b) <= 0;
 }
 
 bool operator>(big_integer const& a, big_integer const& b) {
-    return !(a <= b);
+    return compare(a, b) > 0;
 }
 
 bool operator!=(big_integer const& a, big_integer const& b) {
-    return !(a == b);
+    return compare(a, b) != 0;
 }
 
 bool operator>=(big_integer const& a, big_integer const& b) {
-    return !(a < b);
+    return compare(a, b) >= 0;
 }
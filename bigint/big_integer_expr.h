@@ -0,0 +1,220 @@
+#ifndef BIG_INTEGER_EXPR_H
+#define BIG_INTEGER_EXPR_H
+
+#include <cstddef>
+#include <utility>
+#include "big_integer.h"
+
+// An opt-in lazy layer: an operand wrapped in lazy() makes the operators below build an
+// expression, which is evaluated straight into the destination when it is assigned
+//     s = lazy(a) + b - c + d;    all terms are added in one pass over their limbs
+//     r = lazy(a) * b + c;        the product and the sum share one allocation
+//     acc += lazy(a) * b;         a short factor is multiplied into acc limb by limb
+//     r = (lazy(a) - b) * k;      the difference is built in r and scaled there
+// Expressions refer to their operands, so they have to be assigned in the statement that builds them.
+// An expression becomes a value only on assignment or through an explicit big_integer(expression),
+// which keeps the eager operators out of its way.
+
+// dst = the sum of terms[0, n), terms[i] taken with the opposite sign where negated[i] is set
+void sum_into(big_integer& dst, big_integer const* const* terms, bool const* negated, size_t n);
+// dst = c + a * b, or c - a * b if subtract is set, c may be null for zero
+void mul_add_into(big_integer& dst, big_integer const* c, big_integer const& a, big_integer const& b,
+                  bool subtract);
+
+namespace bigint_expr {
+    template <class E>
+    struct expression {
+        explicit operator big_integer() const {
+            big_integer res;
+            static_cast<E const&>(*this).assign_to(res);
+            return res;
+        }
+    };
+
+    template <size_t N>
+    struct sum : expression<sum<N>> {
+        big_integer const* terms[N];
+        bool negated[N];
+
+        void assign_to(big_integer& dst) const {
+            sum_into(dst, terms, negated, N);
+        }
+    };
+
+    struct product : expression<product> {
+        big_integer const* a;
+        big_integer const* b;
+
+        void assign_to(big_integer& dst) const {
+            mul_add_into(dst, nullptr, *a, *b, false);
+        }
+    };
+
+    // c + a * b, c - a * b, or the negation of the latter for a * b - c
+    struct mul_add : expression<mul_add> {
+        big_integer const* c;
+        product p;
+        bool subtract;
+        bool negate;
+
+        void assign_to(big_integer& dst) const {
+            mul_add_into(dst, c, *p.a, *p.b, subtract);
+            if (negate) {
+                dst = -std::move(dst);
+            }
+        }
+    };
+
+    template <size_t N>
+    struct scaled_sum : expression<scaled_sum<N>> {
+        sum<N> s;
+        big_integer const* k;
+
+        void assign_to(big_integer& dst) const {
+            if (k == &dst) {
+                big_integer res;
+                s.assign_to(res);
+                res *= *k;
+                dst = std::move(res);
+            } else {
+                s.assign_to(dst);
+                dst *= *k;
+            }
+        }
+    };
+
+    template <size_t N, size_t M>
+    sum<N + M> join(sum<N> const& x, sum<M> const& y, bool negate_y) {
+        sum<N + M> res;
+        for (size_t i = 0; i < N; i++) {
+            res.terms[i] = x.terms[i];
+            res.negated[i] = x.negated[i];
+        }
+        for (size_t i = 0; i < M; i++) {
+            res.terms[N + i] = y.terms[i];
+            res.negated[N + i] = (y.negated[i] != negate_y);
+        }
+        return res;
+    }
+
+    inline sum<1> term(big_integer const& a) {
+        sum<1> res;
+        res.terms[0] = &a;
+        res.negated[0] = false;
+        return res;
+    }
+
+    template <size_t N, size_t M>
+    sum<N + M> operator+(sum<N> const& x, sum<M> const& y) {
+        return join(x, y, false);
+    }
+
+    template <size_t N, size_t M>
+    sum<N + M> operator-(sum<N> const& x, sum<M> const& y) {
+        return join(x, y, true);
+    }
+
+    template <size_t N>
+    sum<N + 1> operator+(sum<N> const& x, big_integer const& y) {
+        return join(x, term(y), false);
+    }
+
+    template <size_t N>
+    sum<N + 1> operator-(sum<N> const& x, big_integer const& y) {
+        return join(x, term(y), true);
+    }
+
+    template <size_t N>
+    sum<N + 1> operator+(big_integer const& x, sum<N> const& y) {
+        return join(term(x), y, false);
+    }
+
+    template <size_t N>
+    sum<N + 1> operator-(big_integer const& x, sum<N> const& y) {
+        return join(term(x), y, true);
+    }
+
+    // lazy() never yields a negated single term, so one term times a value is a plain product
+    inline product operator*(sum<1> const& x, big_integer const& y) {
+        product res;
+        res.a = x.terms[0];
+        res.b = &y;
+        return res;
+    }
+
+    inline product operator*(big_integer const& x, sum<1> const& y) {
+        return y * x;
+    }
+
+    template <size_t N>
+    scaled_sum<N> operator*(sum<N> const& x, big_integer const& k) {
+        scaled_sum<N> res;
+        res.s = x;
+        res.k = &k;
+        return res;
+    }
+
+    template <size_t N>
+    scaled_sum<N> operator*(big_integer const& k, sum<N> const& x) {
+        return x * k;
+    }
+
+    inline mul_add make_mul_add(big_integer const& c, product const& p, bool subtract, bool negate) {
+        mul_add res;
+        res.c = &c;
+        res.p = p;
+        res.subtract = subtract;
+        res.negate = negate;
+        return res;
+    }
+
+    inline mul_add operator+(product const& p, big_integer const& c) {
+        return make_mul_add(c, p, false, false);
+    }
+
+    inline mul_add operator+(big_integer const& c, product const& p) {
+        return make_mul_add(c, p, false, false);
+    }
+
+    inline mul_add operator-(product const& p, big_integer const& c) {
+        return make_mul_add(c, p, true, true);
+    }
+
+    inline mul_add operator-(big_integer const& c, product const& p) {
+        return make_mul_add(c, p, true, false);
+    }
+
+    inline big_integer& operator+=(big_integer& dst, product const& p) {
+        mul_add_into(dst, &dst, *p.a, *p.b, false);
+        return dst;
+    }
+
+    inline big_integer& operator-=(big_integer& dst, product const& p) {
+        mul_add_into(dst, &dst, *p.a, *p.b, true);
+        return dst;
+    }
+
+    template <size_t N>
+    big_integer& operator+=(big_integer& dst, sum<N> const& x) {
+        (term(dst) + x).assign_to(dst);
+        return dst;
+    }
+
+    template <size_t N>
+    big_integer& operator-=(big_integer& dst, sum<N> const& x) {
+        (term(dst) - x).assign_to(dst);
+        return dst;
+    }
+}
+
+inline bigint_expr::sum<1> lazy(big_integer const& a) {
+    return bigint_expr::term(a);
+}
+
+template <class E>
+big_integer& big_integer::operator=(bigint_expr::expression<E> const& e) {
+    static_cast<E const&>(e).assign_to(*this);
+    return *this;
+}
+
+#endif // BIG_INTEGER_EXPR_H
@@ -2,11 +2,14 @@
 #include <cassert>
 #include <cstdlib>
 #include <random>
+#include <thread>
 #include <vector>
 #include <utility>
 #include <gtest/gtest.h>
 
 #include "big_integer.h"
+#include "big_divisor.h"
+#include "big_integer_expr.h"
 #include "big_integer_gmp.h"
 
 TEST(correctness, two_plus_two) {
@@ -100,6 +103,39 @@ TEST(correctness, compare_zero_and_minus_zero) {
   EXPECT_TRUE(a == b);
 }
 
+TEST(correctness, mult_short_zero) {
+  big_integer a = -5;
+  big_integer b = a.mult_short(0);
+
+  EXPECT_TRUE(b == 0);
+  EXPECT_FALSE(b < 0);
+  EXPECT_EQ("0", to_string(b));
+  EXPECT_EQ(-15, a.mult_short(3));
+}
+
+TEST(correctness, three_way_compare) {
+  std::vector<big_integer> v = {big_integer("-100000000000000000000000000000000000000"),
+                                big_integer("-18446744073709551617"), big_integer(-5), big_integer(0),
+                                big_integer(3), big_integer("18446744073709551615"),
+                                big_integer("18446744073709551616"),
+                                big_integer("100000000000000000000000000000000000000")};
+  for (size_t i = 0; i != v.size(); ++i) {
+    for (size_t j = 0; j != v.size(); ++j) {
+      int expected = (i < j ? -1 : (i == j ? 0 : 1));
+      EXPECT_EQ(expected, compare(v[i], v[j]));
+      EXPECT_EQ(i < j, v[i] < v[j]);
+      EXPECT_EQ(i <= j, v[i] <= v[j]);
+      EXPECT_EQ(i > j, v[i] > v[j]);
+      EXPECT_EQ(i >= j, v[i] >= v[j]);
+      EXPECT_EQ(i == j, v[i] == v[j]);
+      EXPECT_EQ(i != j, v[i] != v[j]);
+    }
+  }
+  big_integer a("-18446744073709551617");
+  EXPECT_EQ(0, compare(a - a, big_integer()));
+  EXPECT_EQ(0, compare(-(a - a), big_integer()));
+}
+
 TEST(correctness, add) {
   big_integer a = 5;
   big_integer b = 20;
@@ -150,6 +186,19 @@ TEST(correctness, sub_signed) {
   EXPECT_TRUE(a == 85);
 }
 
+TEST(correctness, sub_to_zero) {
+  big_integer a = -5;
+
+  a -= a;
+  EXPECT_TRUE(a == 0);
+  EXPECT_TRUE((a | 5) == 5);
+  EXPECT_TRUE((a ^ 5) == 5);
+
+  big_integer b = -7;
+  EXPECT_EQ(-7, b + a);
+  EXPECT_EQ(-7, b - a);
+}
+
 TEST(correctness, sub_return_value) {
   big_integer a = 5;
   big_integer b = 1;
@@ -229,6 +278,15 @@ TEST(correctness, div_rounding) {
   EXPECT_TRUE(a % b == 3);
 }
 
+TEST(correctness, div_add_back) {
+  // the first quotient limb estimate is one too large and only the full subtraction shows it
+  big_integer a = (big_integer(1) << 191) + 3;
+  big_integer b = (big_integer(1) << 189) + 1;
+
+  EXPECT_TRUE(a / b == 3);
+  EXPECT_TRUE(a % b == b - 1);
+}
+
 TEST(correctness, div_rounding_negative) {
   big_integer a = 23;
   big_integer b = -5;
@@ -249,6 +307,124 @@ TEST(correctness, div_return_value) {
   EXPECT_EQ(25, a);
 }
 
+TEST(correctness, divmod) {
+  int const values[][2] = {{23, 5}, {-23, 5}, {23, -5}, {-23, -5}, {-20, 5}, {3, -7}, {0, -7}};
+  for (auto const& v : values) {
+    std::pair<big_integer, big_integer> qr = divmod(big_integer(v[0]), big_integer(v[1]));
+    EXPECT_EQ(v[0] / v[1], qr.first);
+    EXPECT_EQ(v[0] % v[1], qr.second);
+  }
+
+  big_integer a("-1000000000000000000000000000000000000000000000000000000000007");
+  big_integer b("99999999999999999999999999999");
+  std::pair<big_integer, big_integer> qr = divmod(a, b);
+  EXPECT_EQ(a / b, qr.first);
+  EXPECT_EQ(a % b, qr.second);
+  EXPECT_EQ(a, qr.first * b + qr.second);
+}
+
+TEST(correctness, big_divisor) {
+  int const values[][2] = {{23, 5}, {-23, 5}, {23, -5}, {-23, -5}, {-20, 5}, {3, -7}, {0, -7}};
+  for (auto const& v : values) {
+    big_divisor d(v[1]);
+    EXPECT_EQ(v[0] / v[1], big_integer(v[0]) / d);
+    EXPECT_EQ(v[0] % v[1], big_integer(v[0]) % d);
+  }
+  big_divisor d(big_integer(1) << 63);
+  EXPECT_TRUE(divmod((big_integer(1) << 200) + 5, d) ==
+              std::make_pair(big_integer(1) << 137, big_integer(5)));
+}
+
+TEST(correctness, move) {
+  big_integer a("123456789012345678901234567890123456789");
+  big_integer b = std::move(a);
+  a = -5;
+  EXPECT_EQ(-5, a);
+  a = std::move(b);
+  EXPECT_EQ(a, big_integer("123456789012345678901234567890123456789"));
+
+  big_integer x("-98765432109876543210987654321");
+  big_integer y("12345678901234567890");
+  big_integer xy = x * y;
+  EXPECT_EQ(xy + xy, x * y + x * y);
+  EXPECT_EQ(xy - y, x * y - y);
+  EXPECT_EQ(y - xy, y - x * y);
+  EXPECT_EQ(xy - xy, x * y - x * y);
+  EXPECT_EQ(y * xy, y * (x * y));
+  EXPECT_EQ(xy * xy, (x * y) * (x * y));
+  EXPECT_EQ(-xy, -(x * y));
+  EXPECT_EQ(-xy, abs(x * y));
+  EXPECT_EQ("0", to_string(-(x - x)));
+}
+
+TEST(correctness, expressions) {
+  big_integer a("123456789012345678901234567890123456789");
+  big_integer b("-98765432109876543210987654321");
+  big_integer c("55555555555555555555555555555555555555555555555555");
+  big_integer d = 7;
+  big_integer r;
+
+  r = lazy(a) + b - c + d;
+  EXPECT_EQ(a + b - c + d, r);
+  r = b - lazy(a) - c;
+  EXPECT_EQ(b - a - c, r);
+  r = (lazy(a) + b) - (lazy(c) - d);
+  EXPECT_EQ(a + b - c + d, r);
+  r = lazy(a) - a;
+  EXPECT_EQ("0", to_string(r));
+  r = lazy(a) + b * c - 1;
+  EXPECT_EQ(a + b * c - 1, r);
+  r = lazy(a) * b + c;
+  EXPECT_EQ(a * b + c, r);
+  r = lazy(a) * b - c;
+  EXPECT_EQ(a * b - c, r);
+  r = c - a * lazy(b);
+  EXPECT_EQ(c - a * b, r);
+  r = (lazy(a) - b) * d;
+  EXPECT_EQ((a - b) * d, r);
+  big_integer converted(lazy(a) * b + 1);
+  EXPECT_EQ(a * b + 1, converted);
+
+  big_integer acc = c;
+  acc += lazy(a) * b;
+  EXPECT_EQ(c + a * b, acc);
+  acc -= lazy(a) * b;
+  EXPECT_EQ(c, acc);
+  acc += lazy(a) - b;
+  EXPECT_EQ(c + a - b, acc);
+
+  r = b;
+  r = lazy(r) + r - a;
+  EXPECT_EQ(b + b - a, r);
+  r = b;
+  r = (lazy(a) - r) * r;
+  EXPECT_EQ((a - b) * b, r);
+  r = b;
+  r = lazy(r) * r + r;
+  EXPECT_EQ(b * b + b, r);
+}
+
+TEST(correctness, expressions_random) {
+  std::mt19937 rng(47);
+  for (size_t i = 0; i != 300; ++i) {
+    big_integer v[4];
+    for (big_integer& x : v) {
+      x = big_integer(static_cast<int>(rng() % 2000) - 1000) << static_cast<int>(rng() % 4000);
+      x += static_cast<int>(rng() % 1000);
+    }
+    big_integer r;
+    r = lazy(v[0]) + v[1] - v[2] + v[3];
+    EXPECT_EQ(v[0] + v[1] - v[2] + v[3], r);
+    r = lazy(v[0]) * v[1] + v[2];
+    EXPECT_EQ(v[0] * v[1] + v[2], r);
+    r = v[2] - lazy(v[0]) * v[3];
+    EXPECT_EQ(v[2] - v[0] * v[3], r);
+    r = v[2];
+    r -= lazy(v[0]) * v[1];
+    EXPECT_EQ(v[2] - v[0] * v[1], r);
+  }
+}
+
 TEST(correctness, unary_plus) {
   big_integer a = 123;
   big_integer b = +a;
@@ -422,6 +598,17 @@ TEST(correctness, shr_signed) {
   EXPECT_EQ(-155, a);
 }
 
+TEST(correctness, shr_signed_floor) {
+  EXPECT_EQ(-154, big_integer(-1232) >> 3);
+  EXPECT_EQ(-1, big_integer(-1) >> 1000);
+  EXPECT_EQ(0, big_integer(1) >> 1000);
+  big_integer a = -(big_integer(1) << 200);
+  EXPECT_EQ(-(big_integer(1) << 72), a >> 128);
+  EXPECT_EQ(-(big_integer(1) << 72) - 1, (a - 1) >> 128);
+  EXPECT_EQ(-1, (a - 1) >> 201);
+  EXPECT_EQ(a, (a >> 64) << 64);
+}
+
 TEST(correctness, shr_return_value) {
   big_integer a = 64;
 
@@ -429,6 +616,18 @@ TEST(correctness, shr_return_value) {
   EXPECT_EQ(8, a);
 }
 
+TEST(correctness, data_words) {
+  big_integer a("-18446744073709551617");
+
+  EXPECT_EQ(2u, a.limb_count());
+  EXPECT_EQ(3u, a.size());
+  EXPECT_EQ(1u, a.data(0));
+  EXPECT_EQ(0u, a.data(1));
+  EXPECT_EQ(1u, a.data(2));
+  EXPECT_EQ(0u, a.data(3));
+  EXPECT_EQ(1u, big_integer(0).size());
+}
+
 TEST(correctness, add_long) {
   big_integer a("10000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000");
   big_integer b("100000000000000000000000000000000000000");
@@ -577,6 +776,82 @@ TEST(correctness, string_conv) {
   EXPECT_EQ("-2147483649", to_string(lim));
 }
 
+TEST(correctness, string_conv_threads) {
+  std::vector<std::string> results(4);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i != results.size(); ++i) {
+    threads.emplace_back([&results, i] {
+      big_integer x = (big_integer(1) << static_cast<int>(20000 + 5000 * i)) - 1;
+      results[i] = to_string(big_integer(to_string(x)) - x);
+    });
+  }
+  for (std::thread& t : threads) {
+    t.join();
+  }
+  for (std::string const& r : results) {
+    EXPECT_EQ("0", r);
+  }
+}
+
+TEST(correctness, string_conv_large) {
+  big_integer power = 1;
+  for (size_t i = 0; i != 30011; ++i) {
+    power *= 10;
+  }
+  std::string zeros(30008, '0');
+  EXPECT_EQ("7" + zeros + "123", to_string(power * 7 + 123));
+  EXPECT_EQ("-1" + zeros + "000", to_string(-power));
+  EXPECT_EQ(std::string(30011, '9'), to_string(power - 1));
+
+  EXPECT_EQ(power * 7 + 123, big_integer("7" + zeros + "123"));
+  EXPECT_EQ(-power, big_integer("-1" + zeros + "000"));
+  EXPECT_EQ(power - 1, big_integer(std::string(30011, '9')));
+}
+
+TEST(correctness, string_conv_chunks) {
+  big_integer chunk("10000000000000000000");
+  EXPECT_EQ("9999999999999999999", to_string(chunk - 1));
+  EXPECT_EQ("10000000000000000000", to_string(chunk));
+  EXPECT_EQ("-100000000000000000000000000000000000000", to_string(-chunk * chunk));
+  EXPECT_EQ("18446744073709551615", to_string((big_integer(1) << 64) - 1));
+  EXPECT_EQ("340282366920938463463374607431768211456", to_string(big_integer(1) << 128));
+  EXPECT_EQ("100000000000000000000000000000000000000000000000000000000007",
+            to_string(big_integer("100000000000000000000000000000000000000000000000000000000007")));
+}
+
+TEST(correctness, string_parse) {
+  EXPECT_EQ((big_integer(1) << 64) - 1, big_integer("18446744073709551615"));
+  EXPECT_EQ(big_integer("10000000000000000000") * 10, big_integer("100000000000000000000"));
+  EXPECT_EQ(-(big_integer(1) << 128), big_integer("-340282366920938463463374607431768211456"));
+  EXPECT_EQ(123, big_integer("+00000000000000000000000000000000000000123"));
+  EXPECT_EQ(0, big_integer("-0000000000000000000000000000000"));
+
+  EXPECT_THROW(big_integer("12a3"), std::invalid_argument);
+  EXPECT_THROW(big_integer("+-1"), std::invalid_argument);
+  EXPECT_THROW(big_integer("1-"), std::invalid_argument);
+  EXPECT_THROW(big_integer(" 1"), std::invalid_argument);
+  EXPECT_THROW(big_integer("1234567890123456789012345678901234567890:"), std::invalid_argument);
+}
+
+TEST(correctness, string_parse_blocks) {
+  std::string digits = "-";
+  big_integer expected = 0;
+  for (size_t i = 0; i != 60; ++i) {
+    digits.push_back(static_cast<char>('0' + (i * 7 + 3) % 10));
+    expected = expected * 10 - static_cast<int>((i * 7 + 3) % 10);
+    EXPECT_EQ(expected, big_integer(digits));
+  }
+
+  char const bad[] = {'/', ':', ' ', '\0', static_cast<char>(0xb0)};
+  for (size_t i = 1; i != digits.size(); ++i) {
+    for (char c : bad) {
+      std::string broken = digits;
+      broken[i] = c;
+      EXPECT_THROW(big_integer{broken}, std::invalid_argument);
+    }
+  }
+}
+
 namespace {
 size_t const number_of_iterations = 10;
 size_t const max_size = 2048;
@@ -744,6 +1019,167 @@ TEST(correctness_random, mul) {
   }
 }
 
+TEST(correctness_random, mul_karatsuba) {
+  std::default_random_engine rng(42);
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    big_integer_gmp a, b;
+    a.random(8 * max_size, rng);
+    b.random(8 * max_size - 32 * itn, rng);
+    big_integer_gmp c = a * b;
+    big_integer R = big_integer(to_string(a)) * big_integer(to_string(b));
+    EXPECT_EQ(to_string(c), to_string(R));
+  }
+}
+
+TEST(correctness_random, mul_toom3) {
+  std::default_random_engine rng(7);
+  for (size_t itn = 0; itn != 3; ++itn) {
+    big_integer_gmp a, b;
+    a.random(16 * max_size, rng);
+    b.random(16 * max_size - 2048 * itn, rng);
+    big_integer_gmp c = a * b;
+    big_integer R = big_integer(to_string(a)) * big_integer(to_string(b));
+    EXPECT_EQ(to_string(c), to_string(R));
+  }
+}
+
+TEST(correctness_random, sqr) {
+  std::default_random_engine rng(99);
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    big_integer_gmp a;
+    a.random(max_size * (itn + 1), rng);
+    big_integer_gmp c = a * a;
+    big_integer x(to_string(a));
+    big_integer y = x;
+    EXPECT_EQ(to_string(c), to_string(x * y));
+    x *= x;
+    EXPECT_EQ(to_string(c), to_string(x));
+  }
+}
+
+TEST(correctness_random, mul_ntt) {
+  std::default_random_engine rng(2020);
+  size_t const quarter = 4500 * 32;
+  big_integer a, b, expected;
+  std::vector<big_integer> parts(4);
+  for (size_t i = 0; i != 18000; ++i) {
+    b <<= 32;
+    b += big_integer(static_cast<uint32_t>(rng()));
+    parts[i % 4] <<= 32;
+    parts[i % 4] += big_integer(static_cast<uint32_t>(rng()));
+  }
+  // every part times b stays below the transform threshold
+  for (size_t i = 0; i != 4; ++i) {
+    a += parts[i] << static_cast<int>(i * quarter);
+    expected += (parts[i] * b) << static_cast<int>(i * quarter);
+  }
+  EXPECT_TRUE(a * b == expected);
+
+  big_integer square = b;
+  square *= square;
+  EXPECT_TRUE(square == b * (b + 1) - b);
+}
+
+TEST(correctness_random, div_large) {
+  std::default_random_engine rng(2036);
+  for (size_t itn = 0; itn != 3; ++itn) {
+    size_t words = 90 + 1000 * itn;
+    big_integer a, b;
+    for (size_t i = 0; i != words; ++i) {
+      b <<= 32;
+      b += big_integer(static_cast<uint32_t>(rng()));
+    }
+    for (size_t i = 0; i != words * (itn + 3) / 2; ++i) {
+      a <<= 32;
+      a += big_integer(static_cast<uint32_t>(rng()));
+    }
+    big_integer q = a / b, r = a % b;
+    EXPECT_TRUE(q * b + r == a);
+    EXPECT_TRUE(0 <= r && r < b);
+
+    big_integer exact = q * b;
+    EXPECT_TRUE(exact / b == q);
+    EXPECT_TRUE(exact % b == 0);
+    EXPECT_TRUE((exact - 1) / b == q - 1);
+    EXPECT_TRUE(-a / b == -q);
+  }
+}
+
+TEST(correctness_random, big_divisor) {
+  std::default_random_engine rng(2040);
+  size_t const words[] = {1, 2, 3, 20, 150, 600};
+  for (size_t w : words) {
+    big_integer b;
+    for (size_t i = 0; i != w; ++i) {
+      b <<= 32;
+      b += big_integer(static_cast<uint32_t>(rng()));
+    }
+    big_divisor d(-b);
+    for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+      big_integer a;
+      for (size_t i = 0; i != w * itn / 2 + 1; ++i) {
+        a <<= 32;
+        a += big_integer(static_cast<uint32_t>(rng()));
+      }
+      if (itn % 2) {
+        a = -a;
+      }
+      std::pair<big_integer, big_integer> qr = divmod(a, d);
+      EXPECT_TRUE(qr.first == a / -b);
+      EXPECT_TRUE(qr.second == a % -b);
+    }
+  }
+}
+
+namespace {
+// a random normalized divisor of the given number of limbs
+big_integer rand_normalized(size_t limbs, std::default_random_engine& rng) {
+  big_integer d = 1;
+  for (size_t i = 0; i != 2 * limbs - 1; ++i) {
+    d <<= 32;
+    d += big_integer(static_cast<uint32_t>(rng()));
+  }
+  return d << 31 | big_integer(static_cast<uint32_t>(rng()) >> 1);
+}
+}
+
+TEST(correctness_random, reciprocal) {
+  std::default_random_engine rng(2036);
+  // both sides of the Newton base and up to five steps on top of it
+  size_t const limbs[] = {2, 63, 64, 65, 127, 130, 257, 600, 1500};
+  for (size_t m : limbs) {
+    big_integer power = big_integer(1) << static_cast<int>(128 * m);
+    std::vector<big_integer> divisors = {big_integer(1) << static_cast<int>(64 * m - 1),
+                                         (big_integer(1) << static_cast<int>(64 * m)) - 1};
+    for (size_t itn = 0; itn != 4; ++itn) {
+      divisors.push_back(rand_normalized(m, rng));
+    }
+    for (big_integer const& d : divisors) {
+      big_integer e = power - d * reciprocal(d);
+      EXPECT_TRUE(0 <= e && e < d);
+    }
+  }
+}
+
+TEST(correctness_random, barrett_div) {
+  std::default_random_engine rng(2037);
+  size_t const limbs[] = {2, 65, 300};
+  for (size_t m : limbs) {
+    big_integer d = rand_normalized(m, rng);
+    big_integer inverse = reciprocal(d);
+    for (size_t itn = 0; itn != 6; ++itn) {
+      big_integer a = rand_normalized(m * itn / 2 + 1, rng) >> static_cast<int>(rng() % 64);
+      if (itn == 5) {
+        a = (d << static_cast<int>(64 * m + 5)) - 1;
+      }
+      big_integer q, r;
+      barrett_div_mod(a, d, inverse, q, r);
+      EXPECT_TRUE(q * d + r == a);
+      EXPECT_TRUE(0 <= r && r < d);
+    }
+  }
+}
+
 TEST(correctness_random, div) {
   std::default_random_engine rng(322);
   for (size_t itn = 0; itn != number_of_iterations; ++itn) {
@@ -796,6 +1232,23 @@ TEST(correctness_random, bitwise) {
   }
 }
 
+TEST(correctness_random, bit_shifts_signed) {
+  std::default_random_engine rng(50);
+  for (size_t itn = 0; itn != 100; ++itn) {
+    big_integer_gmp a;
+    a.random(max_size, rng);
+    big_integer R = big_integer(to_string(a)) << static_cast<int>(rng() % 200);
+    if (rng() % 2) {
+      R = -R;
+    }
+    big_integer_gmp g(to_string(R));
+    int shift = static_cast<int>(rng() % 4 == 0 ? 64 * (rng() % 40) : rng() % max_size);
+
+    EXPECT_EQ(to_string(g << shift), to_string(R << shift));
+    EXPECT_EQ(to_string(g >> shift), to_string(R >> shift));
+  }
+}
+
 TEST(correctness_random, bit_shifts) {
   std::default_random_engine rng(42);
   for (size_t itn = 0; itn != number_of_iterations; ++itn) {
@@ -809,6 +1262,29 @@ TEST(correctness_random, bit_shifts) {
   }
 }
 
+TEST(correctness_random, bitwise_low_zero_limbs) {
+  std::default_random_engine rng(49);
+  for (size_t itn = 0; itn != 50; ++itn) {
+    big_integer_gmp a, b;
+    a.random(max_size / 4, rng);
+    b.random(max_size / 2, rng);
+    big_integer A = big_integer(to_string(a)) << static_cast<int>(rng() % 300);
+    big_integer B = big_integer(to_string(b)) << static_cast<int>(rng() % 300);
+    if (rng() % 2) {
+      A = -A;
+    }
+    if (rng() % 2) {
+      B = -B;
+    }
+    big_integer_gmp ga(to_string(A)), gb(to_string(B));
+    EXPECT_EQ(to_string(ga & gb), to_string(A & B));
+    EXPECT_EQ(to_string(ga | gb), to_string(A | B));
+    EXPECT_EQ(to_string(ga ^ gb), to_string(A ^ B));
+    EXPECT_EQ(to_string(gb & ga), to_string(B & A));
+    EXPECT_EQ(-A - 1, ~A);
+  }
+}
+
 // TODO: extend due to idea
 TEST(correctness_twos_complement, simple) {
   std::string a = "-36893488147419103232"; // -(1 << 65)
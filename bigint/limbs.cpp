@@ -0,0 +1,769 @@
+#include "limbs.h"
+
+#include <algorithm>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace limbs {
+    limb add_n(limb* r, limb const* a, limb const* b, size_t n) {
+        limb carry = 0;
+        for (size_t i = 0; i < n; i++) {
+            limb s = a[i] + b[i];
+            limb next = (s < a[i]);
+            s += carry;
+            r[i] = s;
+            carry = next | (s < carry);
+        }
+        return carry;
+    }
+
+    limb sub_n(limb* r, limb const* a, limb const* b, size_t n) {
+        limb borrow = 0;
+        for (size_t i = 0; i < n; i++) {
+            limb x = a[i], y = b[i];
+            limb d = x - y;
+            limb next = (x < y) | (d < borrow);
+            r[i] = d - borrow;
+            borrow = next;
+        }
+        return borrow;
+    }
+
+    int cmp_n(limb const* a, limb const* b, size_t n) {
+        // equal blocks of four limbs are skipped with one branch
+        while (n >= 4 && ((a[n - 1] ^ b[n - 1]) | (a[n - 2] ^ b[n - 2]) |
+                          (a[n - 3] ^ b[n - 3]) | (a[n - 4] ^ b[n - 4])) == 0) {
+            n -= 4;
+        }
+        while (n > 0) {
+            n--;
+            if (a[n] != b[n]) {
+                return a[n] < b[n] ? -1 : 1;
+            }
+        }
+        return 0;
+    }
+
+    limb add_1(limb* r, size_t n, limb x) {
+        for (size_t i = 0; i < n && x; i++) {
+            r[i] += x;
+            x = (r[i] < x);
+        }
+        return x;
+    }
+
+    limb sub_1(limb* r, size_t n, limb x) {
+        for (size_t i = 0; i < n && x; i++) {
+            limb y = r[i];
+            r[i] -= x;
+            x = (y < x);
+        }
+        return x;
+    }
+
+    limb mul_1(limb* r, limb const* a, size_t n, limb x) {
+        return mul_1c(r, a, n, x, 0);
+    }
+
+    limb mul_1c(limb* r, limb const* a, size_t n, limb x, limb c) {
+        double_limb carry = c;
+        for (size_t i = 0; i < n; i++) {
+            double_limb t = static_cast<double_limb>(a[i]) * x + carry;
+            r[i] = static_cast<limb>(t);
+            carry = t >> LIMB_BITS;
+        }
+        return static_cast<limb>(carry);
+    }
+
+    limb addmul_1(limb* r, limb const* a, size_t n, limb x) {
+        double_limb carry = 0;
+        for (size_t i = 0; i < n; i++) {
+            double_limb t = static_cast<double_limb>(a[i]) * x + r[i] + carry;
+            r[i] = static_cast<limb>(t);
+            carry = t >> LIMB_BITS;
+        }
+        return static_cast<limb>(carry);
+    }
+
+    limb submul_1(limb* r, limb const* a, size_t n, limb x) {
+        double_limb carry = 0;
+        for (size_t i = 0; i < n; i++) {
+            double_limb t = static_cast<double_limb>(a[i]) * x + carry;
+            limb low = static_cast<limb>(t);
+            carry = (t >> LIMB_BITS) + (r[i] < low);
+            r[i] -= low;
+        }
+        return static_cast<limb>(carry);
+    }
+
+    // both shifts go two limbs per step with SSE2: a step loads all three limbs it reads before
+    // it stores, and later steps only read limbs further from the destination, so the overlaps
+    // the scalar loops allow stay safe
+    limb lshift(limb* r, limb const* a, size_t n, unsigned bits) {
+        limb out = a[n - 1] >> (LIMB_BITS - bits);
+        size_t i = n - 1;
+#if defined(__SSE2__)
+        __m128i const left = _mm_cvtsi32_si128(static_cast<int>(bits));
+        __m128i const right = _mm_cvtsi32_si128(static_cast<int>(LIMB_BITS - bits));
+        for (; i >= 2; i -= 2) {
+            __m128i high = _mm_loadu_si128(reinterpret_cast<__m128i const*>(a + i - 1));
+            __m128i low = _mm_loadu_si128(reinterpret_cast<__m128i const*>(a + i - 2));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(r + i - 1),
+                             _mm_or_si128(_mm_sll_epi64(high, left), _mm_srl_epi64(low, right)));
+        }
+#endif
+        for (; i > 0; i--) {
+            r[i] = (a[i] << bits) | (a[i - 1] >> (LIMB_BITS - bits));
+        }
+        r[0] = a[0] << bits;
+        return out;
+    }
+
+    limb rshift(limb* r, limb const* a, size_t n, unsigned bits) {
+        limb out = a[0] << (LIMB_BITS - bits);
+        size_t i = 0;
+#if defined(__SSE2__)
+        __m128i const right = _mm_cvtsi32_si128(static_cast<int>(bits));
+        __m128i const left = _mm_cvtsi32_si128(static_cast<int>(LIMB_BITS - bits));
+        for (; i + 2 < n; i += 2) {
+            __m128i low = _mm_loadu_si128(reinterpret_cast<__m128i const*>(a + i));
+            __m128i high = _mm_loadu_si128(reinterpret_cast<__m128i const*>(a + i + 1));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(r + i),
+                             _mm_or_si128(_mm_srl_epi64(low, right), _mm_sll_epi64(high, left)));
+        }
+#endif
+        for (; i + 1 < n; i++) {
+            r[i] = (a[i] >> bits) | (a[i + 1] << (LIMB_BITS - bits));
+        }
+        r[n - 1] = a[n - 1] >> bits;
+        return out;
+    }
+
+    namespace {
+        // (high * B + low) / d for high < d, the remainder goes to rem
+        inline limb div_2by1(limb high, limb low, limb d, limb& rem) {
+#if defined(__x86_64__)
+            limb q;
+            asm("divq %4" : "=a"(q), "=d"(rem) : "a"(low), "d"(high), "rm"(d));
+            return q;
+#else
+            double_limb cur = (static_cast<double_limb>(high) << LIMB_BITS) | low;
+            rem = static_cast<limb>(cur % d);
+            return static_cast<limb>(cur / d);
+#endif
+        }
+
+        // div_2by1 for d with the top bit set by two multiplications with inverse = reciprocal_1(d)
+        // (Moller and Granlund, "Improved division by invariant integers", algorithm 4)
+        inline limb div_2by1_preinv(limb high, limb low, limb d, limb inverse, limb& rem) {
+            double_limb p = static_cast<double_limb>(inverse) * high +
+                    ((static_cast<double_limb>(high + 1) << LIMB_BITS) | low);
+            limb q = static_cast<limb>(p >> LIMB_BITS);
+            limb r = low - q * d;
+            if (r > static_cast<limb>(p)) {
+                q--;
+                r += d;
+            }
+            if (r >= d) {
+                q++;
+                r -= d;
+            }
+            rem = r;
+            return q;
+        }
+    }
+
+    limb divrem_1(limb* q, limb const* a, size_t n, limb d) {
+        limb rem = 0;
+        for (size_t i = n; i > 0; i--) {
+            q[i - 1] = div_2by1(rem, a[i - 1], d, rem);
+        }
+        return rem;
+    }
+
+    limb reciprocal_1(limb d) {
+        limb rem;
+        return div_2by1(~d, ~static_cast<limb>(0), d, rem);
+    }
+
+    // the dividend is shifted on the fly, so the quotient limbs come out of a division by d itself
+    limb divrem_1_preinv(limb* q, limb const* a, size_t n, limb d, unsigned shift, limb inverse) {
+        limb rem = 0;
+        if (shift == 0) {
+            for (size_t i = n; i > 0; i--) {
+                q[i - 1] = div_2by1_preinv(rem, a[i - 1], d, inverse, rem);
+            }
+            return rem;
+        }
+        limb high = a[n - 1];
+        rem = high >> (LIMB_BITS - shift);
+        for (size_t i = n - 1; i > 0; i--) {
+            limb low = a[i - 1];
+            q[i] = div_2by1_preinv(rem, (high << shift) | (low >> (LIMB_BITS - shift)), d, inverse, rem);
+            high = low;
+        }
+        q[0] = div_2by1_preinv(rem, high << shift, d, inverse, rem);
+        return rem >> shift;
+    }
+
+    // Knuth, TAOCP 4.3.1 D: the quotient limb estimated from the top two limbs of the window
+    // a[j, j + m] and refined with the next ones is exact or one too large, the rare second
+    // case shows up as a borrow out of the window and is undone by adding d back
+    void divrem(limb* q, limb* a, size_t n, limb const* d, size_t m, limb inverse) {
+        limb const top = d[m - 1], next = d[m - 2];
+        for (size_t j = n - m; j > 0; j--) {
+            limb* w = a + j - 1;
+            limb qt, rem;
+            bool refine = true;
+            if (w[m] >= top) {
+                qt = ~static_cast<limb>(0);
+                rem = w[m - 1] + top;
+                refine = (rem >= top);
+            } else {
+                qt = div_2by1_preinv(w[m], w[m - 1], top, inverse, rem);
+            }
+            while (refine && static_cast<double_limb>(qt) * next >
+                    ((static_cast<double_limb>(rem) << LIMB_BITS) | w[m - 2])) {
+                qt--;
+                rem += top;
+                refine = (rem >= top);
+            }
+            limb borrow = submul_1(w, d, m, qt);
+            if (w[m] < borrow) {
+                qt--;
+                w[m] += add_n(w, w, d, m);
+            }
+            w[m] -= borrow;
+            q[j - 1] = qt;
+        }
+    }
+
+    void divrem(limb* q, limb* a, size_t n, limb const* d, size_t m) {
+        divrem(q, a, n, d, m, reciprocal_1(d[m - 1]));
+    }
+
+    // multiplies by the inverse of 3 modulo B, the high limb of 3 * q is the borrow into the next limb
+    void divexact_by3(limb* r, limb const* a, size_t n) {
+        limb const inverse = limb(-1) / 3 * 2 + 1;
+        limb const third = limb(-1) / 3;
+        limb borrow = 0;
+        for (size_t i = 0; i < n; i++) {
+            limb x = a[i];
+            limb low = x - borrow;
+            borrow = (x < borrow);
+            limb q = low * inverse;
+            r[i] = q;
+            borrow += (q > third) + (q > 2 * third);
+        }
+    }
+
+    namespace {
+        void mul_basecase(limb* r, limb const* a, size_t n, limb const* b, size_t m) {
+            r[n] = mul_1(r, a, n, b[0]);
+            for (size_t j = 1; j < m; j++) {
+                r[n + j] = addmul_1(r + j, a, n, b[j]);
+            }
+        }
+
+        // off-diagonal products a[i] * a[j], i < j, are summed once and doubled, then the
+        // squares a[i]^2 are added on the diagonal
+        void sqr_basecase(limb* r, limb const* a, size_t n) {
+            std::fill(r, r + 2 * n, 0);
+            for (size_t i = 0; i + 1 < n; i++) {
+                r[n + i] = addmul_1(r + 2 * i + 1, a + i + 1, n - i - 1, a[i]);
+            }
+            lshift(r, r, 2 * n, 1);
+            limb carry = 0;
+            for (size_t i = 0; i < n; i++) {
+                double_limb square = static_cast<double_limb>(a[i]) * a[i];
+                limb low = static_cast<limb>(square), high = static_cast<limb>(square >> LIMB_BITS);
+                limb x = r[2 * i] + low;
+                limb c = (x < low);
+                x += carry;
+                c += (x < carry);
+                r[2 * i] = x;
+                limb y = r[2 * i + 1] + high;
+                carry = (y < high);
+                y += c;
+                carry += (y < c);
+                r[2 * i + 1] = y;
+            }
+        }
+
+        // r[0, n) = |a[0, n) - b[0, m)| for m <= n, returns true if a < b
+        bool abs_sub(limb* r, limb const* a, size_t n, limb const* b, size_t m) {
+            bool less = std::all_of(a + m, a + n, [](limb x) { return x == 0; });
+            if (less) {
+                size_t i = m;
+                while (i > 0 && a[i - 1] == b[i - 1]) {
+                    i--;
+                }
+                less = (i > 0 && a[i - 1] < b[i - 1]);
+            }
+            if (less) {
+                sub_n(r, b, a, m);
+                std::fill(r + m, r + n, 0);
+            } else {
+                limb borrow = sub_n(r, a, b, m);
+                for (size_t i = m; i < n; i++) {
+                    r[i] = a[i] - borrow;
+                    borrow = (a[i] < borrow);
+                }
+            }
+            return less;
+        }
+
+        // r[0, n) += a[0, m) for m <= n, returns carry
+        limb add_to(limb* r, size_t n, limb const* a, size_t m) {
+            return add_1(r + m, n - m, add_n(r, r, a, m));
+        }
+
+        // r[0, n) -= a[0, m) for m <= n, returns borrow
+        limb sub_from(limb* r, size_t n, limb const* a, size_t m) {
+            return sub_1(r + m, n - m, sub_n(r, r, a, m));
+        }
+
+        // scratch enough for mul_n on up to n limbs: a Karatsuba level takes 6h + 1 limbs,
+        // a Toom-3 level 12k + 12 limbs and recurses on k + 1 <= n / 2 limbs
+        size_t mul_n_scratch(size_t n) {
+            size_t size = 0;
+            while (n >= KARATSUBA_THRESHOLD) {
+                size += 4 * n + 20;
+                n -= n / 2;
+            }
+            return size;
+        }
+
+        void mul_n(limb* r, limb const* a, limb const* b, size_t n, limb* scratch);
+        void sqr_n(limb* r, limb const* a, size_t n, limb* scratch);
+
+        // adds the middle term to r[0, 2n) = a0 * b0 + a1 * b1 * B^2l given p = (a1 - a0) * (b1 - b0)
+        // of 2h limbs and its sign, mid takes 2h + 1 limbs
+        void karatsuba_combine(limb* r, size_t n, size_t l, limb const* p, bool negative, limb* mid) {
+            size_t h = n - l;
+            std::copy(r + 2 * l, r + 2 * n, mid);
+            mid[2 * h] = add_1(mid + 2 * l, 2 * (h - l), add_n(mid, mid, r, 2 * l));
+            if (negative) {
+                mid[2 * h] += add_n(mid, mid, p, 2 * h);
+            } else {
+                mid[2 * h] -= sub_n(mid, mid, p, 2 * h);
+            }
+            add_1(r + l + 2 * h + 1, l - 1, add_n(r + l, r + l, mid, 2 * h + 1));
+        }
+
+        // r[0, 2n) = a[0, n) * b[0, n), a = a1 * B^l + a0, b = b1 * B^l + b0,
+        // a0 * b1 + a1 * b0 = a0 * b0 + a1 * b1 - (a1 - a0) * (b1 - b0)
+        void karatsuba(limb* r, limb const* a, limb const* b, size_t n, limb* scratch) {
+            size_t l = n / 2, h = n - l;
+            limb* da = scratch;
+            limb* db = da + h;
+            limb* p = db + h;
+            limb* mid = p + 2 * h;
+            limb* next = mid + 2 * h + 1;
+
+            bool negative = abs_sub(da, a + l, h, a, l);
+            negative ^= abs_sub(db, b + l, h, b, l);
+
+            mul_n(r, a, b, l, next);
+            mul_n(r + 2 * l, a + l, b + l, h, next);
+            mul_n(p, da, db, h, next);
+            karatsuba_combine(r, n, l, p, negative, mid);
+        }
+
+        // r[0, 2n) = a[0, n)^2, the middle term is a0^2 + a1^2 - (a1 - a0)^2
+        void karatsuba_sqr(limb* r, limb const* a, size_t n, limb* scratch) {
+            size_t l = n / 2, h = n - l;
+            limb* da = scratch;
+            limb* p = da + h;
+            limb* mid = p + 2 * h;
+            limb* next = mid + 2 * h + 1;
+
+            abs_sub(da, a + l, h, a, l);
+
+            sqr_n(r, a, l, next);
+            sqr_n(r + 2 * l, a + l, h, next);
+            sqr_n(p, da, h, next);
+            karatsuba_combine(r, n, l, p, false, mid);
+        }
+
+        // e(1), e(-1) and e(2) for e(x) = x[2] * x^2 + x[1] * x + x[0], parts of k limbs
+        // except the top one of t; every value takes k + 1 limbs, returns true if e(-1) < 0
+        bool toom3_evaluate(limb* one, limb* minus_one, limb* two, limb const* x, size_t k, size_t t) {
+            limb const* x0 = x;
+            limb const* x1 = x + k;
+            limb const* x2 = x + 2 * k;
+
+            one[k] = add_n(one, x0, x2, t);
+            std::copy(x0 + t, x0 + k, one + t);
+            one[k] = add_1(one + t, k - t, one[k]);
+            bool negative = abs_sub(minus_one, one, k + 1, x1, k);
+            one[k] += add_n(one, one, x1, k);
+
+            std::copy(x2, x2 + t, two);
+            std::fill(two + t, two + k + 1, 0);
+            lshift(two, two, k + 1, 1);
+            add_to(two, k + 1, x1, k);
+            lshift(two, two, k + 1, 1);
+            add_to(two, k + 1, x0, k);
+            return negative;
+        }
+
+        // recovers r[0, 2n) = c(B^k) from c0 = c(0) in r[0, 2k), c4 = c(infinity) in r[4k, 2n) and
+        // c(1), c(-1) (of the given sign), c(2) of w = 2k + 2 limbs, which are overwritten;
+        // interpolation only divides exactly by 2 and 3:
+        // c0 + c2 + c4 = (c(1) + c(-1)) / 2, c1 + c3 = c(1) - (c0 + c2 + c4),
+        // c1 + 4 * c3 = (c(2) - c0 - 4 * c2 - 16 * c4) / 2
+        void toom3_interpolate(limb* r, size_t n, size_t k, limb* c1, limb* cm1, bool negative, limb* c2) {
+            size_t t = n - 2 * k, w = 2 * k + 2;
+            limb* c0 = r;
+            limb* c4 = r + 4 * k;
+
+            // cm1 := c0 + c2 + c4, c1 := c1 + c3
+            if (negative) {
+                sub_n(cm1, c1, cm1, w);
+            } else {
+                add_n(cm1, c1, cm1, w);
+            }
+            rshift(cm1, cm1, w, 1);
+            sub_n(c1, c1, cm1, w);
+            // cm1 := c2
+            sub_from(cm1, w, c0, 2 * k);
+            sub_from(cm1, w, c4, 2 * t);
+            // c2 := c3
+            sub_from(c2, w, c0, 2 * k);
+            submul_1(c2, cm1, w, 4);
+            limb high = submul_1(c2, c4, 2 * t, 16);
+            sub_from(c2 + 2 * t, w - 2 * t, &high, 1);
+            rshift(c2, c2, w, 1);
+            sub_n(c2, c2, c1, w);
+            divexact_by3(c2, c2, w);
+            // c1 := c1
+            sub_n(c1, c1, c2, w);
+
+            std::fill(r + 2 * k, r + 4 * k, 0);
+            add_to(r + k, 2 * n - k, c1, w);
+            add_to(r + 2 * k, 2 * n - 2 * k, cm1, std::min(w, 2 * n - 2 * k));
+            add_to(r + 3 * k, 2 * n - 3 * k, c2, std::min(w, 2 * n - 3 * k));
+        }
+
+        // r[0, 2n) = a[0, n) * b[0, n) through the product c(x) = a(x) * b(x) of degree 4
+        // at points 0, 1, -1, 2 and infinity
+        void toom3(limb* r, limb const* a, limb const* b, size_t n, limb* scratch) {
+            size_t k = (n + 2) / 3, t = n - 2 * k, w = 2 * k + 2;
+            limb* a1 = scratch;
+            limb* am1 = a1 + k + 1;
+            limb* a2 = am1 + k + 1;
+            limb* b1 = a2 + k + 1;
+            limb* bm1 = b1 + k + 1;
+            limb* b2 = bm1 + k + 1;
+            limb* c1 = b2 + k + 1;
+            limb* cm1 = c1 + w;
+            limb* c2 = cm1 + w;
+            limb* next = c2 + w;
+
+            bool negative = toom3_evaluate(a1, am1, a2, a, k, t);
+            negative ^= toom3_evaluate(b1, bm1, b2, b, k, t);
+
+            mul_n(r, a, b, k, next);
+            mul_n(r + 4 * k, a + 2 * k, b + 2 * k, t, next);
+            mul_n(c1, a1, b1, k + 1, next);
+            mul_n(cm1, am1, bm1, k + 1, next);
+            mul_n(c2, a2, b2, k + 1, next);
+            toom3_interpolate(r, n, k, c1, cm1, negative, c2);
+        }
+
+        // r[0, 2n) = a[0, n)^2, a is evaluated once and c(-1) is never negative
+        void toom3_sqr(limb* r, limb const* a, size_t n, limb* scratch) {
+            size_t k = (n + 2) / 3, t = n - 2 * k, w = 2 * k + 2;
+            limb* a1 = scratch;
+            limb* am1 = a1 + k + 1;
+            limb* a2 = am1 + k + 1;
+            limb* c1 = a2 + k + 1;
+            limb* cm1 = c1 + w;
+            limb* c2 = cm1 + w;
+            limb* next = c2 + w;
+
+            toom3_evaluate(a1, am1, a2, a, k, t);
+
+            sqr_n(r, a, k, next);
+            sqr_n(r + 4 * k, a + 2 * k, t, next);
+            sqr_n(c1, a1, k + 1, next);
+            sqr_n(cm1, am1, k + 1, next);
+            sqr_n(c2, a2, k + 1, next);
+            toom3_interpolate(r, n, k, c1, cm1, false, c2);
+        }
+
+        void mul_n(limb* r, limb const* a, limb const* b, size_t n, limb* scratch) {
+            if (n < KARATSUBA_THRESHOLD) {
+                mul_basecase(r, a, n, b, n);
+            } else if (n < TOOM3_THRESHOLD) {
+                karatsuba(r, a, b, n, scratch);
+            } else {
+                toom3(r, a, b, n, scratch);
+            }
+        }
+
+        void sqr_n(limb* r, limb const* a, size_t n, limb* scratch) {
+            if (n < KARATSUBA_THRESHOLD) {
+                sqr_basecase(r, a, n);
+            } else if (n < TOOM3_THRESHOLD) {
+                karatsuba_sqr(r, a, n, scratch);
+            } else {
+                toom3_sqr(r, a, n, scratch);
+            }
+        }
+    }
+
+    namespace {
+        __extension__ typedef unsigned __int128 uint128_t;
+
+        // arithmetic modulo an odd p < 2^62, products go through Montgomery reduction with R = 2^64,
+        // so mul(x, y) = x * y / R and constants are kept premultiplied by R
+        struct ntt_prime {
+            uint64_t p, inverse, r2;
+
+            ntt_prime(uint64_t p) : p(p), inverse(p) {
+                for (int i = 0; i < 5; i++) {
+                    inverse *= 2 - p * inverse;
+                }
+                inverse = -inverse;
+                uint64_t r = static_cast<uint64_t>((static_cast<uint128_t>(1) << 64) % p);
+                r2 = static_cast<uint64_t>(static_cast<uint128_t>(r) * r % p);
+            }
+
+            uint64_t add(uint64_t x, uint64_t y) const {
+                x += y;
+                return x >= p ? x - p : x;
+            }
+
+            uint64_t sub(uint64_t x, uint64_t y) const {
+                return x >= y ? x - y : x + p - y;
+            }
+
+            uint64_t mul(uint64_t x, uint64_t y) const {
+                uint128_t t = static_cast<uint128_t>(x) * y;
+                uint64_t m = static_cast<uint64_t>(t) * inverse;
+                uint64_t res = static_cast<uint64_t>((t + static_cast<uint128_t>(m) * p) >> 64);
+                return res >= p ? res - p : res;
+            }
+
+            // x * R
+            uint64_t to_mont(uint64_t x) const {
+                return mul(x, r2);
+            }
+
+            // x^e * R for x given as x * R
+            uint64_t pow(uint64_t x, uint64_t e) const {
+                uint64_t res = to_mont(1);
+                for (; e; e >>= 1) {
+                    if (e & 1) {
+                        res = mul(res, x);
+                    }
+                    x = mul(x, x);
+                }
+                return res;
+            }
+
+            // roots[len + j] = w^j * R for the primitive 2len-th root of unity w (or its inverse)
+            // and every len = 1, 2, ..., size / 2, so each butterfly level reads its twiddles in order
+            std::vector<uint64_t> roots(uint64_t generator, size_t size, bool inverse_roots) const {
+                std::vector<uint64_t> res(size);
+                for (size_t len = 1; len < size; len *= 2) {
+                    uint64_t e = (p - 1) / (2 * len);
+                    uint64_t w = pow(to_mont(generator), inverse_roots ? p - 1 - e : e);
+                    res[len] = to_mont(1);
+                    for (size_t j = 1; j < len; j++) {
+                        res[len + j] = mul(res[len + j - 1], w);
+                    }
+                }
+                return res;
+            }
+
+            // decimation in frequency, the output is in bit-reversed order
+            void forward(uint64_t* a, size_t size, uint64_t const* roots) const {
+                for (size_t len = size / 2; len >= 1; len /= 2) {
+                    for (size_t i = 0; i < size; i += 2 * len) {
+                        for (size_t j = 0; j < len; j++) {
+                            uint64_t u = a[i + j], v = a[i + j + len];
+                            a[i + j] = add(u, v);
+                            a[i + j + len] = mul(sub(u, v), roots[len + j]);
+                        }
+                    }
+                }
+            }
+
+            // decimation in time from bit-reversed order, unscaled
+            void inverse_transform(uint64_t* a, size_t size, uint64_t const* roots) const {
+                for (size_t len = 1; len < size; len *= 2) {
+                    for (size_t i = 0; i < size; i += 2 * len) {
+                        for (size_t j = 0; j < len; j++) {
+                            uint64_t u = a[i + j], v = mul(a[i + j + len], roots[len + j]);
+                            a[i + j] = add(u, v);
+                            a[i + j + len] = sub(u, v);
+                        }
+                    }
+                }
+            }
+
+            // res[0, size) = a * b mod (p, x^size - 1) for 64-bit digits, size is a power of two dividing p - 1;
+            // a square (b is a) is transformed once
+            void convolution(uint64_t* res, std::vector<uint64_t> const& a, std::vector<uint64_t> const& b,
+                             size_t size, uint64_t generator) const {
+                std::fill(res, res + size, 0);
+                for (size_t i = 0; i < a.size(); i++) {
+                    res[i] = a[i] % p;
+                }
+                std::vector<uint64_t> roots_forward = roots(generator, size, false);
+                forward(res, size, roots_forward.data());
+                if (&a == &b) {
+                    for (size_t i = 0; i < size; i++) {
+                        res[i] = mul(res[i], res[i]);
+                    }
+                } else {
+                    std::vector<uint64_t> fb(size, 0);
+                    for (size_t i = 0; i < b.size(); i++) {
+                        fb[i] = b[i] % p;
+                    }
+                    forward(fb.data(), size, roots_forward.data());
+                    for (size_t i = 0; i < size; i++) {
+                        res[i] = mul(res[i], fb[i]);
+                    }
+                }
+                inverse_transform(res, size, roots(generator, size, true).data());
+                // the pointwise products lost a factor of R, 1 / size is applied together with it
+                uint64_t scale = to_mont(to_mont(p - (p - 1) / size));
+                for (size_t i = 0; i < size; i++) {
+                    res[i] = mul(res[i], scale);
+                }
+            }
+        };
+
+        // p = c * 2^k + 1 with primitive root g, transforms up to 2^55 long,
+        // p1 * p2 * p3 > 2^183 bounds every convolution coefficient
+        uint64_t const NTT_P1 = 29ull << 57 | 1, NTT_G1 = 3;
+        uint64_t const NTT_P2 = 69ull << 55 | 1, NTT_G2 = 5;
+        uint64_t const NTT_P3 = 27ull << 56 | 1, NTT_G3 = 5;
+        size_t const NTT_VALUE_LIMBS = 192 / LIMB_BITS;
+        size_t const NTT_DIGIT_LIMBS = 64 / LIMB_BITS;
+
+        // a[0, n) as 64-bit digits
+        std::vector<uint64_t> ntt_digits(limb const* a, size_t n) {
+            std::vector<uint64_t> res((n + NTT_DIGIT_LIMBS - 1) / NTT_DIGIT_LIMBS, 0);
+            for (size_t i = 0; i < n; i++) {
+                res[i / NTT_DIGIT_LIMBS] |= static_cast<uint64_t>(a[i]) << (i % NTT_DIGIT_LIMBS * LIMB_BITS);
+            }
+            return res;
+        }
+
+        // r[0, n + m) = a[0, n) * b[0, m), the convolution of 64-bit digits is computed modulo
+        // three primes and every coefficient is recovered from its residues by Garner's algorithm
+        void ntt_mul(limb* r, limb const* a, size_t n, limb const* b, size_t m) {
+            bool square = (a == b && n == m);
+            std::vector<uint64_t> da = ntt_digits(a, n), db;
+            if (!square) {
+                db = ntt_digits(b, m);
+            }
+            std::vector<uint64_t> const& second = (square ? da : db);
+            size_t count = da.size() + second.size() - 1;
+            size_t size = 1;
+            while (size < count) {
+                size *= 2;
+            }
+            ntt_prime const f1(NTT_P1), f2(NTT_P2), f3(NTT_P3);
+            std::vector<uint64_t> r1(size), r2(size), r3(size);
+            f1.convolution(r1.data(), da, second, size, NTT_G1);
+            f2.convolution(r2.data(), da, second, size, NTT_G2);
+            f3.convolution(r3.data(), da, second, size, NTT_G3);
+
+            // x = x1 + x2 * p1 + x3 * p1 * p2
+            uint64_t inverse_p1 = f2.pow(f2.to_mont(NTT_P1 % NTT_P2), NTT_P2 - 2);
+            uint64_t p1 = f3.to_mont(NTT_P1 % NTT_P3);
+            uint128_t p1p2 = static_cast<uint128_t>(NTT_P1) * NTT_P2;
+            uint64_t p1p2_low = static_cast<uint64_t>(p1p2), p1p2_high = static_cast<uint64_t>(p1p2 >> 64);
+            uint64_t inverse_p1p2 = f3.pow(f3.to_mont(p1p2 % NTT_P3), NTT_P3 - 2);
+
+            size_t total = n + m;
+            std::fill(r, r + total, 0);
+            for (size_t i = 0; i < count; i++) {
+                uint64_t x1 = r1[i];
+                uint64_t x2 = f2.mul(f2.sub(r2[i], x1 % NTT_P2), inverse_p1);
+                uint64_t x3 = f3.mul(f3.sub(f3.sub(r3[i], x1 % NTT_P3), f3.mul(x2, p1)), inverse_p1p2);
+
+                uint128_t low = static_cast<uint128_t>(x2) * NTT_P1 + x1;
+                uint128_t t0 = static_cast<uint128_t>(x3) * p1p2_low + static_cast<uint64_t>(low);
+                uint128_t t1 = static_cast<uint128_t>(x3) * p1p2_high + (t0 >> 64) + (low >> 64);
+                uint64_t words[3] = {static_cast<uint64_t>(t0), static_cast<uint64_t>(t1),
+                                     static_cast<uint64_t>(t1 >> 64)};
+
+                limb value[NTT_VALUE_LIMBS];
+                for (size_t k = 0; k < NTT_VALUE_LIMBS; k++) {
+                    value[k] = static_cast<limb>(words[k * LIMB_BITS / 64] >> (k * LIMB_BITS % 64));
+                }
+                size_t at = i * NTT_DIGIT_LIMBS;
+                add_to(r + at, total - at, value, std::min(NTT_VALUE_LIMBS, total - at));
+            }
+        }
+    }
+
+    size_t mul_scratch(size_t n, size_t m) {
+        if (m < KARATSUBA_THRESHOLD || m >= NTT_THRESHOLD) {
+            return 0;
+        }
+        size_t rest = n % m;
+        return 2 * m + std::max(mul_n_scratch(m), rest ? mul_scratch(m, rest) : 0);
+    }
+
+    void mul(limb* r, limb const* a, size_t n, limb const* b, size_t m, limb* scratch) {
+        if (m < KARATSUBA_THRESHOLD) {
+            mul_basecase(r, a, n, b, m);
+            return;
+        }
+        if (m >= NTT_THRESHOLD) {
+            ntt_mul(r, a, n, b, m);
+            return;
+        }
+        limb* t = scratch;
+        limb* next = t + 2 * m;
+
+        mul_n(r, a, b, m, next);
+        size_t done = m;
+        for (; n - done >= m; done += m) {
+            mul_n(t, a + done, b, m, next);
+            limb carry = add_n(r + done, r + done, t, m);
+            std::copy(t + m, t + 2 * m, r + done + m);
+            add_1(r + done + m, m, carry);
+        }
+        if (done < n) {
+            size_t rest = n - done;
+            mul(t, b, m, a + done, rest, next);
+            limb carry = add_n(r + done, r + done, t, m);
+            std::copy(t + m, t + m + rest, r + done + m);
+            add_1(r + done + m, rest, carry);
+        }
+    }
+
+    void mul(limb* r, limb const* a, size_t n, limb const* b, size_t m) {
+        std::vector<limb> scratch(mul_scratch(n, m));
+        mul(r, a, n, b, m, scratch.data());
+    }
+
+    size_t sqr_scratch(size_t n) {
+        return n >= NTT_THRESHOLD ? 0 : mul_n_scratch(n);
+    }
+
+    void sqr(limb* r, limb const* a, size_t n, limb* scratch) {
+        if (n >= NTT_THRESHOLD) {
+            ntt_mul(r, a, n, a, n);
+        } else {
+            sqr_n(r, a, n, scratch);
+        }
+    }
+
+    void sqr(limb* r, limb const* a, size_t n) {
+        std::vector<limb> scratch(sqr_scratch(n));
+        sqr(r, a, n, scratch.data());
+    }
+}